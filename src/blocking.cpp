@@ -0,0 +1,108 @@
+#include "blocking.hpp"
+
+namespace yasync {
+
+BlockingPool::BlockingPool(const BlockingPoolConfig& cfg) : config(cfg) {
+	if(config.threads == 0) config.threads = 1;
+}
+
+BlockingPool::~BlockingPool(){
+	shutdown();
+}
+
+void BlockingPool::reap(){
+	std::vector<std::thread> ex;
+	{
+		std::unique_lock lok(lock);
+		std::swap(ex, exited);
+	}
+	for(auto& t : ex) t.join();
+}
+
+void BlockingPool::enqueue(Queued && q){
+	tasks.push_back(std::move(q));
+	if(tasks.size() > idle && workers.size() < config.threads){
+		std::thread t([this](){ threadwork(); });
+		auto id = t.get_id();
+		workers.emplace(id, std::move(t));
+	}
+	if(idle > 0) cvWork.notify_one();
+}
+
+bool BlockingPool::submit(Task && task){
+	reap();
+	std::unique_lock lok(lock);
+	while(!stahp && config.queueDepth > 0 && (tasks.size() >= config.queueDepth || !parked.empty())) cvRoom.wait(lok);
+	if(stahp) return false;
+	enqueue(Queued{std::move(task), Clock::now()});
+	return true;
+}
+
+bool BlockingPool::post(Task && task){
+	reap();
+	std::unique_lock lok(lock);
+	if(stahp) return false;
+	Queued q{std::move(task), Clock::now()};
+	//behind those parked already, in order
+	if(config.queueDepth > 0 && (tasks.size() >= config.queueDepth || !parked.empty())) parked.push_back(std::move(q));
+	else enqueue(std::move(q));
+	return true;
+}
+
+void BlockingPool::shutdown(){
+	std::vector<std::thread> ws;
+	{
+		std::unique_lock lok(lock);
+		stahp = true;
+		for(auto& w : workers) ws.push_back(std::move(w.second));
+		workers.clear();
+		cvWork.notify_all();
+		cvRoom.notify_all();
+	}
+	for(auto& w : ws) w.join();
+	reap();
+}
+
+BlockingPoolStats BlockingPool::stats(){
+	std::unique_lock lok(lock);
+	return BlockingPoolStats{tasks.size(), parked.size(), static_cast<unsigned>(workers.size()), idle, started, totalWait, maxWait};
+}
+
+void BlockingPool::threadwork(){
+	std::unique_lock lok(lock);
+	while(true){
+		if(tasks.empty()){
+			if(stahp) return;
+			idle++;
+			bool timedout = config.idleTimeout.count() > 0 ? cvWork.wait_for(lok, config.idleTimeout) == std::cv_status::timeout : (cvWork.wait(lok), false);
+			idle--;
+			if(timedout && tasks.empty() && !stahp){
+				//retire, someone else joins us
+				auto self = workers.find(std::this_thread::get_id());
+				if(self != workers.end()){
+					exited.push_back(std::move(self->second));
+					workers.erase(self);
+					return;
+				}
+			}
+			continue;
+		}
+		auto q = std::move(tasks.front());
+		tasks.pop_front();
+		auto waited = Clock::now() - q.at;
+		started++;
+		totalWait += waited;
+		maxWait = std::max(maxWait, waited);
+		//the room goes to the parked first
+		if(!parked.empty()){
+			tasks.push_back(std::move(parked.front()));
+			parked.pop_front();
+		} else cvRoom.notify_one();
+		lok.unlock();
+		q.task();
+		q.task = nullptr;
+		lok.lock();
+	}
+}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <chrono>
+
+namespace yasync {
+
+struct BlockingPoolConfig {
+	/// Maximum number of threads, started on demand
+	unsigned threads = 4;
+	/// Queued tasks after which submission waits for room (posting parks the task instead), `0` for unbounded
+	size_t queueDepth = 1024;
+	/// Threads idle for longer than this exit, `0` to keep them around
+	std::chrono::milliseconds idleTimeout = std::chrono::seconds(10);
+};
+
+struct BlockingPoolStats {
+	using Duration = std::chrono::steady_clock::duration;
+	/// Tasks waiting for a thread, and posted ones waiting for room in the queue
+	size_t queued, parked;
+	/// Live threads, and how many of them are idle
+	unsigned threads, idle;
+	/// Tasks picked up by a thread so far
+	unsigned long long started;
+	/// Time tasks spent queued before a thread picked them up, in total and the longest
+	Duration totalWait, maxWait;
+	inline Duration averageWait() const { return started > 0 ? Duration(totalWait.count() / static_cast<Duration::rep>(started)) : Duration::zero(); }
+};
+
+/**
+ * Threads for blocking work, kept apart from the engine workers so that a slow call never stalls the engine.
+ * Tasks complete back into the engine on their own, typically by completing an OutsideFuture and notifying the engine.
+ * The pool is elastic - threads are started as tasks queue up, up to the limit, and exit after being idle for a while.
+ */
+class BlockingPool {
+	public:
+		using Task = std::function<void()>;
+		using Clock = std::chrono::steady_clock;
+	private:
+		struct Queued {
+			Task task;
+			Clock::time_point at;
+		};
+		BlockingPoolConfig config;
+		std::mutex lock;
+		std::condition_variable cvWork, cvRoom;
+		std::deque<Queued> tasks;
+		/// Posted past the depth, queued as room frees up
+		std::deque<Queued> parked;
+		unsigned idle = 0;
+		bool stahp = false;
+		unsigned long long started = 0;
+		Clock::duration totalWait = Clock::duration::zero(), maxWait = Clock::duration::zero();
+		std::unordered_map<std::thread::id, std::thread> workers;
+		/// Threads that exited on idle, to be joined
+		std::vector<std::thread> exited;
+		void threadwork();
+		void reap();
+		/// Under the lock
+		void enqueue(Queued && q);
+	public:
+		BlockingPool(const BlockingPoolConfig& config = BlockingPoolConfig());
+		BlockingPool(const BlockingPool&) = delete;
+		BlockingPool& operator=(const BlockingPool&) = delete;
+		~BlockingPool();
+		/**
+		 * Queues the task, waiting for room if the queue is full.
+		 * Never from an engine worker, which would stall along - post instead.
+		 * @returns whether the task was accepted, tasks are refused after shutdown
+		 */
+		bool submit(Task && task);
+		/**
+		 * Queues the task without ever waiting. If the queue is full the task is parked, and queued (ahead of submissions waiting for room) as room frees up.
+		 * @returns whether the task was accepted, tasks are refused after shutdown
+		 */
+		bool post(Task && task);
+		/**
+		 * Runs queued tasks to completion and stops all threads
+		 */
+		void shutdown();
+		BlockingPoolStats stats();
+};
+
+}
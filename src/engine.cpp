@@ -2,7 +2,7 @@
 
 namespace yasync {
 
-Yengine::Yengine(unsigned threads) : workers(threads) {
+Yengine::Yengine(unsigned threads, const BlockingPoolConfig& bp) : workers(threads), blocking(bp) {
 	work.cvIdle = &condWLE;
 	work.thresIdle = workers;
 	workets.resize(workers);
@@ -14,10 +14,15 @@ void Yengine::wle(){
 		std::unique_lock lock(notificationsLock);
 		while(work.currentIdle() < work.thresIdle || !notifications.empty()) condWLE.wait(lock);
 	}
+	blocking.shutdown();
 	work.close();
 	for(unsigned i = 0; i < workers; i++) workets[i].join();
 }
 
+size_t Yengine::queued(){
+	return work.size();
+}
+
 void Yengine::execute(const AGenf& gf){
 	gf->setState(FutureState::Queued);
 	work.push(gf);
@@ -70,6 +75,11 @@ void Yengine::threado(AFuture task){
 					case FutureState::Running:
 						task->setState(FutureState::Awaiting);
 						notifiAdd(*awa, task);
+						//completed (outside) before it got awaited, its notification found nothing to chain with
+						if(awa->state() == FutureState::Completed) if(auto naut = notifiDrop(*awa)){
+							task = *naut;
+							break;
+						}
 						return;
 				} else {
 					task->setState(task->done() ? FutureState::Completed : FutureState::Suspended);
@@ -10,6 +10,7 @@
 
 #include "future.hpp"
 #include "threadsafequeue.hpp"
+#include "blocking.hpp"
 
 #ifdef _DEBUG
 #include <iostream>
@@ -503,7 +504,7 @@ template<typename V, typename F, typename S> class GeneratorLGenerator<V, F, S>
 	S state;
 	F g;
 	public:
-		GeneratorLGenerator(S s, F && gen) : state(s), g(std::move(gen)){}
+		GeneratorLGenerator(S && s, F && gen) : state(std::move(s)), g(std::move(gen)){}
 		bool done() const override { return d; }
 		Generesume<V> resume(const Yengine* engine) override {
 			return g(engine, d, state);
@@ -511,7 +512,7 @@ template<typename V, typename F, typename S> class GeneratorLGenerator<V, F, S>
 };
 
 template<typename V, typename F, typename S> Generator<V> lambdagen_spec(_typed<std::variant<AFuture, monoid<V>>>, F && f, S arg){
-	return Generator<V>(new GeneratorLGenerator<V, F, S>(arg, std::move(f)));
+	return Generator<V>(new GeneratorLGenerator<V, F, S>(std::move(arg), std::move(f)));
 }
 
 template<typename F, typename S> auto lambdagen(F && f, S arg){
@@ -519,7 +520,7 @@ template<typename F, typename S> auto lambdagen(F && f, S arg){
 	bool don;
 	S _arg;
 	using V = std::decay_t<decltype(f(engine, don, _arg))>;
-	return lambdagen_spec(_typed<V>{}, std::move(f), arg);
+	return lambdagen_spec(_typed<V>{}, std::move(f), std::move(arg));
 }
 
 class Yengine {
@@ -534,8 +535,20 @@ class Yengine {
 	unsigned workers;
 	std::vector<std::thread> workets;
 	public:
-		Yengine(unsigned threads);
+		/**
+		 * @param threads worker threads
+		 * @param blocking pool for blocking work, @see spawnBlocking
+		 */
+		Yengine(unsigned threads, const BlockingPoolConfig& blocking = BlockingPoolConfig{64, 0});
+		/**
+		 * Blocking work, that would otherwise stall a worker, runs here
+		 */
+		BlockingPool blocking;
 		void wle();
+		/**
+		 * Number of futures queued for execution (or notification), a measure of load
+		 */
+		size_t queued();
 		void execute(const AGenf&);
 		void notify(const ANotf&);
 		/**
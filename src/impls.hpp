@@ -79,6 +79,30 @@ inline Future<void> completed(){
 	return vf;
 }
 
+/**
+ * Runs blocking code (resolving, opening files, compression, synchronous clients...) on the engine's blocking pool, instead of stalling a worker.
+ * Once the engine's blocking pool is shut down, runs in place.
+ * @param engine engine to complete into
+ * @param f `() → R`
+ * @returns result of f
+ */
+template<typename F, typename R = std::invoke_result_t<std::decay_t<F>&>> Future<R> spawnBlocking(Yengine* engine, F && f){
+	auto fp = std::make_shared<std::decay_t<F>>(std::forward<F>(f));
+	auto n = std::make_shared<OutsideFuture<R>>();
+	bool queued = engine->blocking.post([engine, fp, n](){
+		if constexpr (std::is_void<R>::value){
+			(*fp)();
+			n->completed();
+		} else n->completed((*fp)());
+		engine->notify(n);
+	});
+	if(queued) return n;
+	if constexpr (std::is_void<R>::value){
+		(*fp)();
+		return completed();
+	} else return completed((*fp)());
+}
+
 template<typename T> class AggregateFuture : public INotfT<std::vector<T>> {
 	unsigned bal = 0;
 	std::mutex synch;
@@ -95,7 +119,7 @@ template<typename T> class AggregateFuture : public INotfT<std::vector<T>> {
 			}
 			engine <<= f >> [self = slf.lock(), engine](T t){
 				std::unique_lock lok(self->synch);
-				self->results.add(std::move(t));
+				self->results.push_back(std::move(t));
 				if(--self->bal == 0) engine->notify(self);
 			};
 			return *this;
@@ -147,7 +171,7 @@ template<typename T> T blawait(Yengine* engine, Future<T> f){
 	};
 	std::unique_lock lok(synch);
 	while(!t.get()) cvDone.wait(lok);
-	return *t;
+	return std::move(*t);
 }
 template<> void blawait<void>(Yengine* engine, Future<void> f);
 
@@ -1,6 +1,7 @@
 #include "io.hpp"
 #include <stdexcept>
 #include <array>
+#include <atomic>
 #include "impls.hpp"
 
 #ifdef _WIN32
@@ -13,9 +14,25 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <cstring>
+#include <sys/sendfile.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+#include <deque>
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
 #endif
 
 constexpr size_t DEFAULT_BUFFER_SIZE = 4096;
+constexpr size_t SEND_CHUNK = 1 << 16;
+#ifndef _WIN32
+constexpr size_t IOV_BATCH = 64;
+constexpr size_t SENDFILE_MAX = 0x7ffff000; //most the kernel sends in one go
+#endif
 
 namespace yasync::io {
 
@@ -33,53 +50,736 @@ class StandardHandledResource : public IHandledResource {
 
 IHandledResource::IHandledResource(ResourceHandle r, bool b) : rh(r), iopor(b) {}
 IHandledResource::~IHandledResource(){}
+bool IHandledResource::detach(){ return false; }
+
+const char* WriteBuffer::data() const {
+	return std::visit(overloaded {
+		[](const std::vector<char>& d){ return d.data(); },
+		[](const std::string& d){ return d.data(); },
+		[](const std::shared_ptr<const std::vector<char>>& d){ return d->data(); },
+		[](const std::shared_ptr<const std::string>& d){ return d->data(); },
+		[](const std::string_view& d){ return d.data(); },
+		[](const SharedView& d){ return d.data.data(); },
+	}, storage);
+}
+size_t WriteBuffer::size() const {
+	return std::visit(overloaded {
+		[](const std::vector<char>& d){ return d.size(); },
+		[](const std::string& d){ return d.size(); },
+		[](const std::shared_ptr<const std::vector<char>>& d){ return d->size(); },
+		[](const std::shared_ptr<const std::string>& d){ return d->size(); },
+		[](const std::string_view& d){ return d.size(); },
+		[](const SharedView& d){ return d.data.size(); },
+	}, storage);
+}
+std::vector<char> WriteBuffer::take() &&{
+	if(auto v = std::get_if<std::vector<char>>(&storage)) return std::move(*v);
+	return std::vector<char>(data(), data()+size());
+}
+
+OutboundQueue::OutboundQueue(WriteBuffer&& buf){
+	push(std::move(buf));
+}
+OutboundQueue& OutboundQueue::push(WriteBuffer&& buf){
+	if(buf.empty()) return *this;
+	left += buf.size();
+	bufs.push_back(std::move(buf));
+	return *this;
+}
+void OutboundQueue::advance(size_t bytes, bool keep){
+	left -= bytes;
+	while(bytes > 0){
+		auto rem = bufs[head].size() - off;
+		if(bytes < rem){
+			off += bytes;
+			return;
+		}
+		bytes -= rem;
+		if(!keep) bufs[head] = WriteBuffer();
+		head++;
+		off = 0;
+	}
+	if(!keep && head == bufs.size()){
+		bufs.clear();
+		head = 0;
+	}
+}
+#ifndef _WIN32
+size_t OutboundQueue::gather(::iovec* iov, size_t max) const {
+	size_t n = 0;
+	for(size_t i = head; i < bufs.size() && n < max; i++, n++){
+		size_t o = i == head ? off : 0;
+		iov[n].iov_base = const_cast<char*>(bufs[i].data() + o);
+		iov[n].iov_len = bufs[i].size() - o;
+	}
+	return n;
+}
+#endif
+OutboundQueue& OutboundQueue::append(OutboundQueue&& other){
+	for(size_t i = other.head; i < other.bufs.size(); i++){
+		if(i == other.head && other.off > 0) push(std::vector<char>(other.frontData(), other.frontData()+other.frontSize()));
+		else push(std::move(other.bufs[i]));
+	}
+	other = OutboundQueue();
+	return *this;
+}
+std::vector<char> OutboundQueue::concat() &&{
+	if(head + 1 == bufs.size() && off == 0){
+		auto ret = std::move(bufs[head]).take();
+		*this = OutboundQueue();
+		return ret;
+	}
+	std::vector<char> ret;
+	ret.reserve(left);
+	for(size_t i = head; i < bufs.size(); i++) ret.insert(ret.end(), bufs[i].data() + (i == head ? off : 0), bufs[i].data() + bufs[i].size());
+	*this = OutboundQueue();
+	return ret;
+}
+
+Future<IAIOResource::WriteResult> IAIOResource::_writev(OutboundQueue&& data){
+	return _write(std::move(data).concat());
+}
+Future<IAIOResource::ReadResult> IAIOResource::_readAt(uint64_t, size_t){
+	return completed(ReadResult::Err("Positional IO not supported"));
+}
+Future<IAIOResource::WriteResult> IAIOResource::_writeAt(uint64_t, OutboundQueue&&){
+	return completed(WriteResult::Err("Positional IO not supported"));
+}
+Future<IAIOResource::SendResult> IAIOResource::_sendFile(const IOResource& file, uint64_t offset, uint64_t length){
+	struct Copy {
+		uint64_t off, left, sent;
+		std::optional<Future<ReadResult>> rd;
+		std::optional<Future<WriteResult>> wr;
+	};
+	return defer(lambdagen([self = slf.lock(), file](const Yengine*, bool& done, Copy& c) -> Generesume<SendResult> {
+		if(c.wr){
+			auto res = c.wr->result();
+			c.wr = std::nullopt;
+			if(auto err = res.err()){
+				done = true;
+				return SendResult::Err(*err);
+			}
+		}
+		if(c.rd){
+			auto res = c.rd->result();
+			c.rd = std::nullopt;
+			if(auto err = res.err()){
+				done = true;
+				return SendResult::Err(*err);
+			}
+			auto& data = *res.ok();
+			if(data.size() < std::min<uint64_t>(c.left, SEND_CHUNK)) c.left = data.size(); //EOF, this is the last chunk
+			if(!data.empty()){
+				c.off += data.size();
+				c.left -= data.size();
+				c.sent += data.size();
+				return *(c.wr = self->write(std::move(data)));
+			}
+		}
+		if(c.left == 0){
+			done = true;
+			return SendResult::Ok(c.sent);
+		}
+		return *(c.rd = file->readAt<std::vector<char>>(c.off, std::min<uint64_t>(c.left, SEND_CHUNK)));
+	}, Copy{offset, length > 0 ? length : UINT64_MAX, 0, std::nullopt, std::nullopt}));
+}
+
+#ifdef _WIN32
+/**
+ * Synchronous positional IO on an overlapped handle.
+ * The low bit of the event keeps the completion off the port.
+ */
+static BOOL positionalIO(bool wr, HANDLE h, char* data, DWORD size, uint64_t offset, DWORD& transferred){
+	OVERLAPPED ov = {};
+	ov.Offset = static_cast<DWORD>(offset);
+	ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+	HANDLE ev = ::CreateEventA(NULL, TRUE, FALSE, NULL);
+	if(!ev) return FALSE;
+	ov.hEvent = reinterpret_cast<HANDLE>(reinterpret_cast<ULONG_PTR>(ev) | 1);
+	BOOL ok = wr ? ::WriteFile(h, data, size, &transferred, &ov) : ::ReadFile(h, data, size, &transferred, &ov);
+	if(!ok && ::GetLastError() == ERROR_IO_PENDING) ok = ::GetOverlappedResult(h, &ov, &transferred, TRUE);
+	auto err = ::GetLastError();
+	::CloseHandle(ev);
+	::SetLastError(err);
+	return ok;
+}
+#endif
 
 class FileResource : public IAIOResource {
 	IOYengine::Ticket ioengine;
 	HandledResource res;
 	std::array<char, DEFAULT_BUFFER_SIZE> buffer;
 	std::shared_ptr<OutsideFuture<IOCompletionInfo>> engif;
-	void notify(IOCompletionInfo inf) override {
-		engif->completed(std::move(inf));
+	#ifndef _WIN32
+	/// The descriptor can not be polled, IO goes to the file IO pool
+	bool offload = false;
+	#endif
+	struct IdleWatch {
+		TickTack* timer = nullptr;
+		TickTack::Duration idle;
+		/// Pending check, stale ones find it replaced
+		TickTack::Id check = TickTack::UnId;
+	};
+	std::mutex idling;
+	IdleWatch watch;
+	std::atomic<bool> watching = false;
+	std::atomic<TickTack::Clock::rep> activity = 0;
+	/// What woke the waiting operation
+	enum class Woken { Ready, Cancelled, Idle };
+	/// Readiness (from the IO thread) and cancellations (from anywhere) race to wake the waiting operation, the first one wins
+	std::mutex arming;
+	Woken woken = Woken::Ready;
+	#ifndef _WIN32
+	/// Waits so far, and the one in progress (with the events it waits for), `0` if none
+	uint64_t waits = 0, waitingOn = 0;
+	int waitingFor = 0;
+	#endif
+	/// Data moved
+	inline void touch(){
+		if(watching.load(std::memory_order_relaxed)) activity.store(TickTack::Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+	}
+	/// Under the lock
+	void idleArm(TickTack::Duration after){
+		watch.check = watch.timer->after(after, [w = slf](TickTack::Id id, bool cancelled){
+			if(cancelled) return;
+			if(auto self = w.lock()) static_cast<FileResource*>(self.get())->idleCheck(id);
+		});
+	}
+	void idleCheck(TickTack::Id id){
+		std::unique_lock lok(idling);
+		if(watch.check != id) return;
+		auto since = TickTack::Clock::now() - TickTack::TimePoint(TickTack::Duration(activity.load(std::memory_order_relaxed)));
+		if(since < watch.idle) return idleArm(watch.idle - since);
+		//nothing waiting is nothing stalled, look again later
+		if(!hangUp(Woken::Idle, 0)) return idleArm(watch.idle);
+		//once fired, the watch is done
+		watch.check = TickTack::UnId;
+		watching = false;
+	}
+	/**
+	 * Wakes the operation waiting past the mark as hung up, for it to fail with the reason.
+	 * @returns whether there was one to wake
+	 */
+	bool hangUp(Woken why, uint64_t mark){
+		#ifdef _WIN32
+		{
+			std::unique_lock lok(arming);
+			woken = why;
+		}
+		return CancelIoEx(res->rh, overlapped());
+		#else
+		{
+			std::unique_lock lok(arming);
+			if(waitingOn <= mark) return false;
+			waitingOn = 0;
+			woken = why;
+			engif->completed(EPOLLHUP);
+		}
 		engine->notify(engif);
+		return true;
+		#endif
 	}
-	void cancel() override {
+	SysError cancelledError(){
+		Woken why;
+		{
+			std::unique_lock lok(arming);
+			why = std::exchange(woken, Woken::Ready);
+		}
+		if(why == Woken::Idle) return SysError("Idle timeout");
+		return SysError("Operation cancelled (hang up on the other side, or cancellation requested)");
+	}
+	#ifndef _WIN32
+	struct ZeroCopy {
+		/// Writes that sent without copying, held until the kernel is done with their last send
+		struct Held {
+			uint32_t last;
+			OutboundQueue data;
+		};
+		/// Number of the next send without copying, counted the way the kernel does
+		uint32_t next = 0;
+		std::deque<Held> held;
+		ZeroCopyStats stats;
+		inline unsigned long long pending() const { return stats.sent - stats.zeroCopied - stats.copied; }
+	};
+	std::mutex zcLock;
+	ZeroCopy zc;
+	/// Smallest write sent without copying, `0` when off
+	std::atomic<size_t> zcThreshold = 0;
+	/// SO_ZEROCOPY is set, notices may come in even once turned off
+	std::atomic<bool> zcSocket = false;
+	/// Collects the kernel's notices of sends done, releasing the writes no longer read from
+	void zcReap(){
+		std::unique_lock lok(zcLock);
+		while(true){
+			alignas(::cmsghdr) char control[128];
+			::msghdr msg = {};
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof(control);
+			if(::recvmsg(res->rh, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break; //none left
+			for(auto cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)){
+				if(!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) && !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) continue;
+				::sock_extended_err ee;
+				std::memcpy(&ee, CMSG_DATA(cm), sizeof(ee));
+				if(ee.ee_origin != SO_EE_ORIGIN_ZEROCOPY || ee.ee_errno != 0) continue;
+				//sends lo to hi, wrapping around
+				uint32_t lo = ee.ee_info, span = ee.ee_data - lo;
+				(ee.ee_code & SO_EE_CODE_ZEROCOPY_COPIED ? zc.stats.copied : zc.stats.zeroCopied) += span + 1ull;
+				for(auto it = zc.held.begin(); it != zc.held.end();){
+					if(static_cast<uint32_t>(it->last - lo) <= span) it = zc.held.erase(it);
+					else ++it;
+				}
+			}
+		}
+	}
+	/// Writes out what it can of the queue, without copying if large enough
+	ssize_t sendOut(OutboundQueue& data){
+		std::array<::iovec, IOV_BATCH> iov;
+		auto cnt = data.gather(iov.data(), iov.size());
+		auto threshold = zcThreshold.load(std::memory_order_relaxed);
+		if(threshold > 0 && data.size() >= threshold){
+			::msghdr msg = {};
+			msg.msg_iov = iov.data();
+			msg.msg_iovlen = cnt;
+			auto n = ::sendmsg(res->rh, &msg, MSG_ZEROCOPY | MSG_DONTWAIT | MSG_NOSIGNAL);
+			if(n > 0){
+				data.advance(n, true);
+				std::unique_lock lok(zcLock);
+				zc.next++;
+				zc.stats.sent++;
+				return n;
+			}
+			//ENOBUFS is out of memory to pin the data (locked memory limit), copy it instead
+			if(n == 0 || errno != ENOBUFS) return n;
+		}
+		auto n = ::writev(res->rh, iov.data(), cnt);
+		if(n > 0){
+			std::unique_lock lok(zcLock);
+			if(threshold > 0) zc.stats.small++;
+			//what's written may include the rest of a buffer partly sent without copying
+			data.advance(n, zc.pending() > 0);
+		}
+		return n;
+	}
+	/// Once the write is done (or failed), holds its buffers if the kernel may still be reading them
+	void zcRetain(OutboundQueue& data){
+		if(!zcSocket.load(std::memory_order_relaxed)) return;
+		std::unique_lock lok(zcLock);
+		if(zc.pending() > 0) zc.held.push_back({zc.next - 1, std::move(data)});
+	}
+	/**
+	 * Events woken up with.
+	 * Notices of sends done come in as an error - they're collected, and the call itself is left to tell of an actual error.
+	 */
+	int readiness(bool wr){
+		int leve = engif->running();
+		if(zcSocket.load(std::memory_order_relaxed) && (leve & EPOLLERR) && !(leve & EPOLLHUP)){
+			zcReap();
+			leve |= wr ? EPOLLOUT : EPOLLIN;
+		}
+		return leve;
+	}
+	#endif
+	void notify(IOCompletionInfo inf) override {
 		#ifdef _WIN32
-		CancelIoEx(res->rh, overlapped());
-		// notify(IOCompletionInfo { FALSE, 0, ERROR_OPERATION_ABORTED });
+		engif->completed(std::move(inf));
 		#else
-		notify(EPOLLHUP);
+		{
+			std::unique_lock lok(arming);
+			//the wait was cancelled already, or it's readiness left over from a cancelled wait for the other direction
+			if(!waitingOn || !(inf & (waitingFor | EPOLLHUP | EPOLLERR))) return;
+			waitingOn = 0;
+			engif->completed(std::move(inf));
+		}
 		#endif
+		engine->notify(engif);
+	}
+	void cancel() override {
+		hangUp(Woken::Cancelled, 0);
 	}
 	#ifdef _WIN32
 	#else
-	using EPollRegResult = result<bool, std::string>;
+	/// The operation is about to wait for the events, before (re)arming the descriptor as they may come in right away
+	void await(int events){
+		touch(); //idleness is that of the wait
+		std::unique_lock lok(arming);
+		waitingOn = ++waits;
+		waitingFor = events;
+		woken = Woken::Ready;
+	}
+	/// Arming failed, there is nothing to wait for
+	void unawait(){
+		std::unique_lock lok(arming);
+		waitingOn = 0;
+	}
+	using EPollRegResult = result<bool, SysError>;
 	EPollRegResult lazyEpollReg(bool wr){
 		if(res->iopor) return false;
 		::epoll_event epm;
 		epm.events = (wr ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
 		epm.data.ptr = this;
+		await(wr ? EPOLLOUT : EPOLLIN);
 		if(::epoll_ctl(ioengine->ioPo->rh, EPOLL_CTL_ADD, res->rh, &epm)){
+			unawait();
 			if(errno == EPERM){
 				//The file does not support non-blocking io :(
 				//That means that all r/w will succeed (and block). So we report ourselves ready for IO, and off to EOD we go!
+				//Only this once though, anything after goes to the file IO pool
+				offload = true;
 				engif->completed(wr ? EPOLLOUT : EPOLLIN);
 				return !(res->iopor = true);
 			} else return retSysError<EPollRegResult>("Register to epoll failed");
 		}
 		return res->iopor = true;
 	}
-	using EPollRearmResult = result<void, std::string>;
+	using EPollRearmResult = result<void, SysError>;
 	EPollRearmResult epollRearm(bool wr){
 		if(!res->iopor) return EPollRearmResult::Ok();
 		::epoll_event epm;
 		epm.events = (wr ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
 		epm.data.ptr = this;
-		return ::epoll_ctl(ioengine->ioPo->rh, EPOLL_CTL_MOD, res->rh, &epm) ? retSysError<EPollRearmResult>("Register to epoll failed") : EPollRearmResult::Ok();
+		await(wr ? EPOLLOUT : EPOLLIN);
+		if(::epoll_ctl(ioengine->ioPo->rh, EPOLL_CTL_MOD, res->rh, &epm)){
+			unawait();
+			return retSysError<EPollRearmResult>("Register to epoll failed");
+		}
+		return EPollRearmResult::Ok();
+	}
+	/**
+	 * Moves data to the destination through a kernel pipe, never touching user space.
+	 * The pipe's capacity bounds the data in flight.
+	 */
+	Future<PipeReport> splice(std::shared_ptr<FileResource> to, const PipeOptions& options){
+		struct KernelPipe {
+			fd_t r = -1, w = -1;
+			~KernelPipe(){
+				if(r >= 0) ::close(r);
+				if(w >= 0) ::close(w);
+			}
+		};
+		struct Splice {
+			std::shared_ptr<KernelPipe> pipe;
+			size_t cap;
+			size_t inPipe;
+			bool eod;
+			/// Resource whose readiness is awaited
+			FileResource* waiting;
+			PipeReport report;
+		};
+		auto kp = std::make_shared<KernelPipe>();
+		fd_t pp[2];
+		if(::pipe2(pp, O_CLOEXEC | O_NONBLOCK)) return completed(PipeReport{0, 0, SysError::last("Kernel pipe creation failed")});
+		kp->r = pp[0];
+		kp->w = pp[1];
+		::fcntl(kp->w, F_SETPIPE_SZ, static_cast<int>(std::max<size_t>(options.maxInFlight, 1))); //best effort, the pipe max size may be lower
+		auto cap = ::fcntl(kp->w, F_GETPIPE_SZ);
+		return defer(lambdagen([this, self = slf.lock(), to, limit = options.limit](const Yengine*, bool& done, Splice& sp) -> Generesume<PipeReport> {
+			auto finish = [&](std::optional<SysError> error){
+				done = true;
+				sp.report.error = error;
+				return std::move(sp.report);
+			};
+			//woken up by a hang up alone, either the peer is gone (and splicing tells) or it's cancellation
+			bool hup = false;
+			if(sp.waiting){
+				bool wr = sp.waiting == to.get();
+				int leve = sp.waiting->readiness(wr);
+				hup = !(leve & (wr ? EPOLLOUT : EPOLLIN));
+				if(hup && !(leve & (EPOLLHUP|EPOLLERR))) return finish(SysError::detail("Epoll wrong event", leve));
+				sp.waiting = nullptr;
+			}
+			while(true){
+				bool progress = false, srcBlocked = false;
+				auto left = limit > 0 ? limit - sp.report.read : UINT64_MAX;
+				if(!sp.eod && sp.inPipe < sp.cap && left > 0){
+					auto n = ::splice(res->rh, nullptr, sp.pipe->w, nullptr, std::min<uint64_t>(sp.cap - sp.inPipe, left), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+					if(n > 0){
+						touch();
+						sp.inPipe += n;
+						sp.report.read += n;
+						progress = true;
+					} else if(n == 0) sp.eod = true;
+					else if(errno == EWOULDBLOCK || errno == EAGAIN) srcBlocked = true;
+					else if(errno != EINTR) return finish(SysError::last("Splice from source failed"));
+				}
+				if(left == 0) sp.eod = true;
+				if(sp.inPipe > 0){
+					auto n = ::splice(sp.pipe->r, nullptr, to->res->rh, nullptr, sp.inPipe, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+					if(n > 0){
+						to->touch();
+						sp.inPipe -= n;
+						sp.report.written += n;
+						progress = true;
+					} else if(n < 0 && errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) return finish(SysError::last("Splice to destination failed"));
+				}
+				if(sp.eod && sp.inPipe == 0) return finish(std::nullopt);
+				if(progress) continue;
+				if(hup) return finish(cancelledError());
+				//nothing moved - the destination is full, or the source is dry
+				auto wait = srcBlocked && sp.inPipe < sp.cap ? this : to.get();
+				bool wr = wait == to.get();
+				auto rr = wait->lazyEpollReg(wr);
+				if(auto err = rr.err()) return finish(*err);
+				if(!*rr.ok() && wait->engif->state() != FutureState::Completed) if(auto err = wait->epollRearm(wr).err()) return finish(*err);
+				sp.waiting = wait;
+				return AFuture(wait->engif);
+			}
+		}, Splice{kp, cap > 0 ? static_cast<size_t>(cap) : std::max<size_t>(options.maxInFlight, 1), 0, false, nullptr, PipeReport()}));
+	}
+	/// IO on the descriptor would block the engine - known once registered, told by the file type before
+	bool blocking(){
+		if(res->iopor) return offload;
+		struct ::stat st;
+		return ::fstat(res->rh, &st) == 0 && (S_ISREG(st.st_mode) || S_ISDIR(st.st_mode) || S_ISBLK(st.st_mode));
+	}
+	Future<ReadResult> offloadRead(size_t bytes){
+		auto n = std::make_shared<OutsideFuture<ReadResult>>();
+		bool queued = ioengine->fileIO.post([this, self = slf.lock(), n, bytes](){
+			std::vector<char> data;
+			ssize_t transferred;
+			while(true){
+				auto at = data.size();
+				//what's asked for but at least a buffer unit, or in growing chunks until EOF
+				auto chunk = bytes > 0 ? std::max(bytes - at, DEFAULT_BUFFER_SIZE) : std::max(DEFAULT_BUFFER_SIZE, at);
+				data.resize(at + chunk);
+				transferred = ::read(res->rh, data.data()+at, chunk);
+				data.resize(at + std::max<ssize_t>(transferred, 0));
+				if(transferred < 0 && errno == EINTR) continue;
+				if(transferred <= 0 || (bytes > 0 && data.size() >= bytes)) break;
+			}
+			n->completed(transferred < 0 ? retSysError<ReadResult>("Read failed") : ReadResult::Ok(std::move(data)));
+			engine->notify(n);
+		});
+		if(!queued) return completed(ReadResult::Err("File IO pool is shut down"));
+		return n;
+	}
+	Future<WriteResult> offloadWrite(OutboundQueue&& data){
+		auto n = std::make_shared<OutsideFuture<WriteResult>>();
+		bool queued = ioengine->fileIO.post([this, self = slf.lock(), n, q = std::make_shared<OutboundQueue>(std::move(data))](){
+			auto wr = WriteResult::Ok();
+			std::array<::iovec, IOV_BATCH> iov;
+			while(!q->empty()){
+				auto transferred = ::writev(res->rh, iov.data(), q->gather(iov.data(), iov.size()));
+				if(transferred < 0 && errno == EINTR) continue;
+				if(transferred < 0){
+					wr = retSysError<WriteResult>("Write failed");
+					break;
+				}
+				if(transferred == 0){
+					wr = WriteResult::Err("Write reached EOWTF(?)");
+					break;
+				}
+				q->advance(transferred);
+			}
+			n->completed(std::move(wr));
+			engine->notify(n);
+		});
+		if(!queued) return completed(WriteResult::Err("File IO pool is shut down"));
+		return n;
 	}
 	#endif
 	public:
 		friend class IOYengine;
+		std::optional<ResourceHandle> handle() const override { return res->rh; }
+		#ifndef _WIN32
+		std::optional<ResourceHandle> detach() override {
+			if(!res->detach()) return std::nullopt;
+			if(res->iopor && !offload) ::epoll_ctl(ioengine->ioPo->rh, EPOLL_CTL_DEL, res->rh, nullptr);
+			res->iopor = false;
+			return res->rh;
+		}
+		#endif
+		bool cork(bool on) override {
+			#ifdef TCP_CORK
+			int v = on;
+			return !offload && ::setsockopt(res->rh, IPPROTO_TCP, TCP_CORK, &v, sizeof(v)) == 0;
+			#else
+			return false;
+			#endif
+		}
+		bool zeroCopy(size_t threshold) override {
+			#ifdef _WIN32
+			return false;
+			#else
+			if(offload) return false;
+			if(threshold > 0 && !zcSocket){
+				int v = 1;
+				if(::setsockopt(res->rh, SOL_SOCKET, SO_ZEROCOPY, &v, sizeof(v))) return false;
+				zcSocket = true;
+			}
+			zcThreshold = threshold;
+			return true;
+			#endif
+		}
+		ZeroCopyStats zeroCopyStats() override {
+			#ifdef _WIN32
+			return ZeroCopyStats();
+			#else
+			if(zcSocket) zcReap();
+			std::unique_lock lok(zcLock);
+			auto stats = zc.stats;
+			stats.held = zc.held.size();
+			return stats;
+			#endif
+		}
+		#ifndef _WIN32
+		uint64_t operationMark() override {
+			std::unique_lock lok(arming);
+			return waits;
+		}
+		void cancelMarked(uint64_t mark) override {
+			hangUp(Woken::Cancelled, mark);
+		}
+		#endif
+		bool idleTimeout(TickTack* timer, TickTack::Duration idle) override {
+			#ifndef _WIN32
+			if(offload) return false; //files never stall
+			#endif
+			std::unique_lock lok(idling);
+			if(watch.check != TickTack::UnId) watch.timer->stop(watch.check);
+			watch = IdleWatch{timer, idle};
+			watching = timer && idle > TickTack::Duration::zero();
+			if(!watching) return true;
+			activity = TickTack::Clock::now().time_since_epoch().count();
+			idleArm(idle);
+			return true;
+		}
+		Future<SendResult> _sendFile(const IOResource& file, uint64_t offset, uint64_t length) override {
+			#ifdef _WIN32
+			return IAIOResource::_sendFile(file, offset, length);
+			#else
+			auto src = file->handle();
+			//sendfile to a file would block the engine, the pool offloaded copy does not
+			if(!src || blocking()) return IAIOResource::_sendFile(file, offset, length);
+			struct Progress {
+				off_t off;
+				uint64_t left, sent;
+				std::optional<Future<SendResult>> fallback;
+			};
+			return defer(lambdagen([this, self = slf.lock(), file, src = *src](const Yengine*, bool& done, Progress& p) -> Generesume<SendResult> {
+				if(p.fallback){
+					done = true;
+					auto res = p.fallback->result();
+					return res.mapOk([&p](uint64_t sent){ return p.sent + sent; });
+				}
+				if(done) return SendResult::Ok(p.sent);
+				{
+					auto rr = lazyEpollReg(true);
+					if(auto err = rr.err()){
+						done = true;
+						return SendResult::Err(*err);
+					} else if(*rr.ok()) return AFuture(engif);
+				}
+				if(engif->state() == FutureState::Completed){
+					int leve = readiness(true);
+					if(!(leve & EPOLLOUT)){
+						done = true;
+						if(leve & (EPOLLHUP|EPOLLERR)) return SendResult::Err(cancelledError());
+						return SendResult::Err(SysError::detail("Epoll wrong event", leve));
+					}
+				}
+				while(p.left > 0){
+					auto sent = ::sendfile(res->rh, src, &p.off, std::min<uint64_t>(p.left, SENDFILE_MAX));
+					if(sent > 0){
+						touch();
+						p.left -= sent;
+						p.sent += sent;
+						continue;
+					}
+					if(sent == 0) break; //EOF
+					if(errno == EINTR) continue;
+					if(errno == EWOULDBLOCK || errno == EAGAIN){
+						if(auto e = epollRearm(true).err()){
+							done = true;
+							return SendResult::Err(*e);
+						}
+						return AFuture(engif);
+					}
+					if((errno == EINVAL || errno == ENOSYS || errno == ESPIPE) && p.sent == 0){
+						//this pair can't sendfile, copy it over instead
+						return *(p.fallback = IAIOResource::_sendFile(file, p.off, p.left == UINT64_MAX ? 0 : p.left));
+					}
+					done = true;
+					return retSysError<SendResult>("sendfile failed");
+				}
+				done = true;
+				return SendResult::Ok(p.sent);
+			}, Progress{static_cast<off_t>(offset), length > 0 ? length : UINT64_MAX, 0, std::nullopt}));
+			#endif
+		}
+		Future<PipeReport> _pipeTo(const IOResource& dst, const PipeOptions& options) override {
+			#ifndef _WIN32
+			auto to = std::dynamic_pointer_cast<FileResource>(dst);
+			//splicing from or into a file would block the engine
+			if(to && !to->blocking() && !blocking() && !buffered()) return splice(to, options);
+			#endif
+			return IAIOResource::_pipeTo(dst, options);
+		}
+		//Positional IO runs on the file IO pool, so that any number of positional operations can run at once (and apart from the stream)
+		Future<ReadResult> _readAt(uint64_t offset, size_t bytes) override {
+			auto n = std::make_shared<OutsideFuture<ReadResult>>();
+			bool queued = ioengine->fileIO.post([this, self = slf.lock(), n, offset, bytes](){
+				std::vector<char> data(bytes);
+				size_t got = 0;
+				bool failed = false;
+				while(got < bytes){
+					#ifdef _WIN32
+					DWORD transferred = 0;
+					if(!positionalIO(false, res->rh, data.data()+got, static_cast<DWORD>(std::min<size_t>(bytes-got, MAXDWORD)), offset+got, transferred)){
+						failed = ::GetLastError() != ERROR_HANDLE_EOF;
+						break;
+					}
+					#else
+					auto transferred = ::pread(res->rh, data.data()+got, bytes-got, offset+got);
+					if(transferred < 0 && errno == EINTR) continue;
+					if(transferred < 0){
+						failed = true;
+						break;
+					}
+					#endif
+					if(transferred == 0) break;
+					got += transferred;
+				}
+				data.resize(got);
+				n->completed(failed ? retSysError<ReadResult>("Positional read failed") : ReadResult::Ok(std::move(data)));
+				engine->notify(n);
+			});
+			if(!queued) return completed(ReadResult::Err("File IO pool is shut down"));
+			return n;
+		}
+		Future<WriteResult> _writeAt(uint64_t offset, OutboundQueue&& data) override {
+			auto n = std::make_shared<OutsideFuture<WriteResult>>();
+			bool queued = ioengine->fileIO.post([this, self = slf.lock(), n, offset, q = std::make_shared<OutboundQueue>(std::move(data))](){
+				auto wr = WriteResult::Ok();
+				uint64_t at = offset;
+				while(!q->empty()){
+					#ifdef _WIN32
+					DWORD transferred = 0;
+					if(!positionalIO(true, res->rh, const_cast<char*>(q->frontData()), static_cast<DWORD>(std::min<size_t>(q->frontSize(), MAXDWORD)), at, transferred)){
+						wr = retSysError<WriteResult>("Positional write failed");
+						break;
+					}
+					#else
+					std::array<::iovec, IOV_BATCH> iov;
+					auto transferred = ::pwritev(res->rh, iov.data(), q->gather(iov.data(), iov.size()), at);
+					if(transferred < 0 && errno == EINTR) continue;
+					if(transferred < 0){
+						wr = retSysError<WriteResult>("Positional write failed");
+						break;
+					}
+					#endif
+					if(transferred == 0){
+						wr = WriteResult::Err("Write reached EOWTF(?)");
+						break;
+					}
+					q->advance(transferred);
+					at += transferred;
+				}
+				n->completed(std::move(wr));
+				engine->notify(n);
+			});
+			if(!queued) return completed(WriteResult::Err("File IO pool is shut down"));
+			return n;
+		}
 		FileResource(IOYengine* e, HandledResource hr) : IAIOResource(e->engine), ioengine(e->ticket()), res(std::move(hr)), buffer(), engif(new OutsideFuture<IOCompletionInfo>()) {
 			#ifdef _WIN32
 			if(!res->iopor){
@@ -88,38 +788,51 @@ class FileResource : public IAIOResource {
 				::SetFileCompletionNotificationModes(res->rh, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS);
 			}
 			#else
+			//epoll refuses regular files (and directories, block devices), they are always "ready" and would block a worker
+			struct ::stat st;
+			if(!res->iopor && ::fstat(res->rh, &st) == 0) offload = S_ISREG(st.st_mode) || S_ISDIR(st.st_mode) || S_ISBLK(st.st_mode);
 			#endif
 		}
 		FileResource(const FileResource& cpy) = delete;
 		FileResource(FileResource&& mov) = delete;
-		~FileResource(){}
+		~FileResource(){
+			if(watch.check != TickTack::UnId) watch.timer->stop(watch.check);
+			#ifndef _WIN32
+			//closing the descriptor leaves the registration in place while another process holds a copy of it
+			if(res->iopor && !offload) ::epoll_ctl(ioengine->ioPo->rh, EPOLL_CTL_DEL, res->rh, nullptr);
+			#endif
+		}
 		Future<ReadResult> _read(size_t bytes){
+			#ifndef _WIN32
+			if(offload) return offloadRead(bytes);
+			#endif
 			//self.get() == this   exists to memory-lock dangling IO resource to this lambda generator
 			return defer(lambdagen([this, self = slf.lock(), bytes](const Yengine*, bool& done, std::vector<char>& data) -> Generesume<ReadResult> {
-				if(done) return ReadResult::Ok(data);
+				if(done) return ReadResult::Ok(std::move(data));
 				#ifdef _WIN32 //TODO FIXME a UB lives somewhere in here, making itself known only on large data reads
 				if(engif->state() == FutureState::Completed){
 					IOCompletionInfo result = engif->running();
 					if(!result.status) switch(result.lerr){
 						case ERROR_HANDLE_EOF:
 							done = true;
-							return ReadResult::Ok(data);
+							return ReadResult::Ok(std::move(data));
 						case ERROR_OPERATION_ABORTED:
 							done = true;
-							return ReadResult::Err("Operation cancelled (hang up on the other side, or cancellation requested)");
+							return ReadResult::Err(cancelledError());
 						default:
 							done = true;
 							return retSysError<ReadResult>("Async Read failure", result.lerr);
 					} else {
 						if(result.transferred == 0){ //EOF on ECONNRESET
 							done = true;
-							return ReadResult::Ok(data);
+							return ReadResult::Ok(std::move(data));
 						}
+						touch();
 						data.insert(data.end(), buffer.begin(), buffer.begin()+result.transferred);
 						overlapped()->Offset += result.transferred;
 						if(bytes > 0 && (done = data.size() >= bytes)){
 							done = true;
-							return ReadResult::Ok(data);;
+							return ReadResult::Ok(std::move(data));
 						}
 					}
 				}
@@ -127,20 +840,21 @@ class FileResource : public IAIOResource {
 				while(ReadFile(res->rh, buffer.begin(), buffer.size(), &transferred, overlapped())){
 					if(transferred == 0){ //EOF on ECONNRESET
 						done = true;
-						return ReadResult::Ok(data);
+						return ReadResult::Ok(std::move(data));
 					}
+					touch();
 					data.insert(data.end(), buffer.begin(), buffer.begin() + transferred);
 					overlapped()->Offset += transferred;
 					if(bytes > 0 && data.size() >= bytes){
 						done = true;
-						return ReadResult::Ok(data);;
+						return ReadResult::Ok(std::move(data));
 					}
 				}
 				switch(::GetLastError()){
 					case ERROR_IO_PENDING: break;
 					case ERROR_HANDLE_EOF:
 						done = true;
-						return ReadResult::Ok(data);;
+						return ReadResult::Ok(std::move(data));
 					default:
 						done = true;
 						return retSysError<ReadResult>("Sync Read failure");
@@ -152,38 +866,37 @@ class FileResource : public IAIOResource {
 					else if(*rr.ok()) return AFuture(engif);
 				}
 				if(engif->state() == FutureState::Completed){
-					int leve = engif->running();
-					switch(leve){
-						case EPOLLIN: {
-							int transferred;
-							while((transferred = ::read(res->rh, buffer.data(), buffer.size())) > 0){
-								data.insert(data.end(), buffer.begin(), buffer.begin()+transferred);
-								if(bytes > 0 && data.size() >= bytes){
-									done = true;
-									return ReadResult::Ok(data);;
-								}
-							}
-							if(transferred == 0){
-								done = true;
-								return ReadResult::Ok(data);;
-							}
-							if(errno != EWOULDBLOCK && errno != EAGAIN){
+					int leve = readiness(false);
+					//events are a mask, data may still be pending together with a hang up
+					if(leve & EPOLLIN){
+						//read straight into the result, the kernel copy is the only copy
+						ssize_t transferred;
+						while(true){
+							auto at = data.size();
+							data.resize(at + DEFAULT_BUFFER_SIZE);
+							transferred = ::read(res->rh, data.data()+at, DEFAULT_BUFFER_SIZE);
+							data.resize(at + std::max<ssize_t>(transferred, 0));
+							if(transferred <= 0) break;
+							touch();
+							if(bytes > 0 && data.size() >= bytes){
 								done = true;
-								return retSysError<ReadResult>("Read failed");
+								return ReadResult::Ok(std::move(data));
 							}
-							break;
 						}
-						case EPOLLHUP:
+						if(transferred == 0){
 							done = true;
-							return ReadResult::Err("Operation cancelled (hang up on the other side, or cancellation requested)");
-						case EPOLLPRI:
-						case EPOLLOUT: //NO! BAD EPOLL!
-						default: {
+							return ReadResult::Ok(std::move(data));
+						}
+						if(errno != EWOULDBLOCK && errno != EAGAIN){
 							done = true;
-							std::ostringstream erm;
-							erm << "Epoll wrong event (" << leve << ")\n";
-							return retSysError<ReadResult>(erm.str());
+							return retSysError<ReadResult>("Read failed");
 						}
+					} else if(leve & (EPOLLHUP|EPOLLERR)){
+						done = true;
+						return ReadResult::Err(cancelledError());
+					} else {
+						done = true;
+						return ReadResult::Err(SysError::detail("Epoll wrong event", leve));
 					}
 				}
 				if(auto e = epollRearm(false).err()){
@@ -196,7 +909,13 @@ class FileResource : public IAIOResource {
 			}, std::vector<char>()));
 		}
 		Future<WriteResult> _write(std::vector<char>&& data){
-			return defer(lambdagen([this, self = slf.lock()](const Yengine*, bool& done, std::vector<char>& data) -> Generesume<WriteResult> {
+			return _writev(OutboundQueue(std::move(data)));
+		}
+		Future<WriteResult> _writev(OutboundQueue&& data){
+			#ifndef _WIN32
+			if(offload) return offloadWrite(std::move(data));
+			#endif
+			return defer(lambdagen([this, self = slf.lock()](const Yengine*, bool& done, OutboundQueue& data) -> Generesume<WriteResult> {
 				if(data.empty()) done = true;
 				if(done) return WriteResult::Ok();
 				#ifdef _WIN32
@@ -205,7 +924,7 @@ class FileResource : public IAIOResource {
 					if(!result.status) switch(result.lerr){
 						case ERROR_OPERATION_ABORTED:
 							done = true;
-							return WriteResult::Err("Operation cancelled (hang up on the other side, or cancellation requested)");
+							return WriteResult::Err(cancelledError());
 						default:
 							done = true;
 							return retSysError<WriteResult>("Async Write failed", result.lerr);
@@ -214,7 +933,8 @@ class FileResource : public IAIOResource {
 							done = true;
 							return WriteResult::Err("Write reached EOWTF(?)");
 						}
-						data.erase(data.begin(), data.begin()+result.transferred);
+						touch();
+						data.advance(result.transferred);
 						overlapped()->Offset += result.transferred;
 						if(data.empty()){
 							done = true;
@@ -223,12 +943,13 @@ class FileResource : public IAIOResource {
 					}
 				}
 				DWORD transferred = 0;
-				while(WriteFile(res->rh, data.data(), data.size(), &transferred, overlapped())){
+				while(WriteFile(res->rh, data.frontData(), data.frontSize(), &transferred, overlapped())){
 					if(transferred == 0){
 						done = true;
 						return WriteResult::Err("Write reached EOWTF(?)");
 					}
-					data.erase(data.begin(), data.begin()+transferred);
+					touch();
+					data.advance(transferred);
 					overlapped()->Offset += transferred;
 					if(data.empty()){
 						done = true;
@@ -245,55 +966,41 @@ class FileResource : public IAIOResource {
 					if(auto err = rr.err()) return WriteResult::Err(*err);
 					else if(*rr.ok()) return AFuture(engif);
 				}
+				//the kernel may still be reading what was sent without copying
+				auto finish = [&](WriteResult&& r){
+					done = true;
+					zcRetain(data);
+					return std::move(r);
+				};
 				if(engif->state() == FutureState::Completed){
-					int leve = engif->running();
-					switch(leve){
-						case EPOLLOUT: {
-							int transferred;
-							while((transferred = ::write(res->rh, data.data(), data.size())) > 0){
-								data.erase(data.begin(), data.begin()+transferred);
-								if(data.empty()){
-									done = true;
-									return WriteResult::Ok();
-								}
-							}
-							if(transferred == 0){
-								done = true;
-								return WriteResult::Err("Write reached EOWTF(?)");
-							}
-							if(errno != EWOULDBLOCK && errno != EAGAIN){
-								done = true;
-								return retSysError<WriteResult>("Write failed");
-							}
-							break;
-						}
-						case EPOLLHUP:
-							done = true;
-							return WriteResult::Err("Operation cancelled (hang up on the other side, or cancellation requested)");
-						case EPOLLPRI:
-						case EPOLLIN: //NO! BAD EPOLL!
-						default: {
-							done = true;
-							std::ostringstream erm;
-							erm << "Epoll wrong event (" << leve << ")\n";
-							return retSysError<WriteResult>(erm.str());
+					int leve = readiness(true);
+					if(leve & EPOLLOUT){
+						ssize_t transferred;
+						while((transferred = sendOut(data)) > 0){
+							touch();
+							if(data.empty()) return finish(WriteResult::Ok());
 						}
+						if(transferred == 0) return finish(WriteResult::Err("Write reached EOWTF(?)"));
+						if(errno != EWOULDBLOCK && errno != EAGAIN) return finish(retSysError<WriteResult>("Write failed"));
+					} else if(leve & (EPOLLHUP|EPOLLERR)){
+						return finish(WriteResult::Err(cancelledError()));
+					} else {
+						return finish(WriteResult::Err(SysError::detail("Epoll wrong event", leve)));
 					}
 				}
 				if(auto e = epollRearm(true).err()){
 					std::cout << "epoll rearm failed for " << engif.get() << "\n";
-					done = true;
-					return WriteResult::Err(*e);
+					return finish(WriteResult::Err(*e));
 				}
 				#endif
 				return AFuture(engif);
-			}, data));
+			}, std::move(data)));
 		}
 };
 
 template<> Future<IAIOResource::ReadResult> IAIOResource::read<std::vector<char>>(){
 	if(readbuff.empty()) return _read(0);
-	return _read(0) >> [this, self = slf.lock()](auto rr){ return rr.mapOk([this](auto data){
+	return _read(0) >> [this, self = slf.lock()](auto rr){ return std::move(rr).mapOk([this](auto data){
 		std::vector<char> nd;
 		nd.reserve(readbuff.size() + data.size());
 		MoveAppend(readbuff, nd);
@@ -308,7 +1015,7 @@ template<> Future<IAIOResource::ReadResult> IAIOResource::read<std::vector<char>
 		return completed(IAIOResource::ReadResult(std::move(ret)));
 	}
 	auto n2r = upto-readbuff.size();
-	return _read(n2r) >> [this, self = slf.lock(), n2r](auto rr){ return rr.mapOk([=](auto data){
+	return _read(n2r) >> [this, self = slf.lock(), n2r](auto rr){ return std::move(rr).mapOk([=](auto data){
 		std::vector<char> nd;
 		nd.reserve(readbuff.size() + std::min(n2r, data.size()));
 		MoveAppend(readbuff, nd);
@@ -322,9 +1029,16 @@ template<> Future<IAIOResource::ReadResult> IAIOResource::read<std::vector<char>
 	});};
 }
 
+template<> Future<IAIOResource::ReadResult> IAIOResource::readSome<std::vector<char>>(){
+	if(readbuff.empty()) return _read(1);
+	std::vector<char> ret;
+	std::swap(ret, readbuff);
+	return completed(IAIOResource::ReadResult(std::move(ret)));
+}
+
 template<> Future<IAIOResource::ReadResult> IAIOResource::peek<std::vector<char>>(size_t upto){
 	if(readbuff.size() >= upto) return completed(IAIOResource::ReadResult(std::vector<char>(readbuff.begin(), readbuff.begin()+upto)));
-	return _read(upto-readbuff.size()) >> [this, self = slf.lock(), upto](auto rr){ return rr.mapOk([=](auto data){
+	return _read(upto-readbuff.size()) >> [this, self = slf.lock(), upto](auto rr){ return std::move(rr).mapOk([=](auto data){
 		std::move(data.begin(), data.end(), std::back_inserter(readbuff));
 		return std::vector<char>(readbuff.begin(), readbuff.begin()+std::min(readbuff.size(), upto));
 	});};
@@ -346,36 +1060,247 @@ template<> IAIOResource::Writer& IAIOResource::Writer::operator<<<std::ostringst
 
 //L2
 
-IAIOResource::Writer::Writer(IOResource r) : resource(r), eodnot(new OutsideFuture<IAIOResource::WriteResult>()), lflush(completed(IAIOResource::WriteResult())) {}
+struct IAIOResource::Writer::Flusher {
+	IOResource resource;
+	FlushPolicy policy;
+	std::weak_ptr<Flusher> slf;
+	std::mutex lock;
+	using Notif = std::shared_ptr<OutsideFuture<WriteResult>>;
+	/// Flushed data waiting for the outstanding write to finish
+	OutboundQueue pending;
+	/// Flushes waiting for the pending data to be written out
+	std::vector<Notif> waiting;
+	/// Producers waiting for congestion relief
+	std::vector<Notif> drains;
+	bool writing = false;
+	size_t inflight = 0;
+	TickTack::Id cork = TickTack::UnId;
+	/// The socket is corked
+	bool corked = false;
+	WriteResult failed = WriteResult::Ok();
+	bool closing = false;
+	bool eodone = false;
+	Notif eodnot;
+	Flusher(IOResource r, const FlushPolicy& p) : resource(r), policy(p), eodnot(new OutsideFuture<WriteResult>()) {
+		if(policy.highWater > 0) policy.corkBytes = std::min(policy.corkBytes, policy.highWater);
+	}
+	inline size_t buffered() const { return pending.size() + inflight; }
+	void complete(std::vector<Notif>& ns, const WriteResult& r){
+		for(auto& n : ns){
+			n->completed(WriteResult(r));
+			resource->engine->notify(n);
+		}
+		ns.clear();
+	}
+	void uncork(){
+		if(cork != TickTack::UnId) policy.corkTimer->stop(cork);
+		cork = TickTack::UnId;
+	}
+	void start(){
+		uncork();
+		//resources that can't be corked aren't asked again
+		if(policy.tcpCork && !corked) policy.tcpCork = corked = resource->cork(true);
+		writing = true;
+		inflight = pending.size();
+		OutboundQueue q;
+		std::swap(q, pending);
+		std::vector<Notif> batch;
+		std::swap(batch, waiting);
+		resource->engine <<= resource->writev(std::move(q)) >> [self = slf.lock(), batch = std::move(batch)](auto wr) mutable {
+			std::unique_lock lok(self->lock);
+			self->written(std::move(wr), batch);
+		};
+	}
+	/// Starts the next write if there is anything to write, and it's not held back
+	void kick(){
+		if(writing) return;
+		if(failed.isErr()){
+			finish();
+			return;
+		}
+		if(pending.empty()){
+			//flush boundary, the tail goes out
+			if(corked) corked = !resource->cork(false);
+			complete(waiting, WriteResult::Ok());
+			finish();
+			return;
+		}
+		//small flushes are held back for more to join them, until the timer releases them - never the last one
+		if(!closing && policy.corkTimer && pending.size() < policy.corkBytes){
+			if(cork == TickTack::UnId) cork = policy.corkTimer->after(policy.corkDelay, [wself = slf](TickTack::Id id, bool cancelled){
+				if(cancelled) return;
+				if(auto self = wself.lock()){
+					std::unique_lock lok(self->lock);
+					if(self->cork != id) return;
+					self->cork = TickTack::UnId;
+					if(!self->writing && !self->pending.empty()) self->start();
+				}
+			});
+			return;
+		}
+		start();
+	}
+	void written(WriteResult && wr, std::vector<Notif>& batch){
+		writing = false;
+		inflight = 0;
+		if(wr.isErr()) failed = wr;
+		complete(batch, wr);
+		if(failed.isErr()){
+			pending = OutboundQueue();
+			uncork();
+			complete(waiting, failed);
+			complete(drains, failed);
+			finish();
+			return;
+		}
+		if(buffered() <= policy.lowWater) complete(drains, WriteResult::Ok());
+		kick();
+	}
+	void finish(){
+		if(!closing || writing || eodone) return;
+		eodone = true;
+		eodnot->completed(WriteResult(failed));
+		resource->engine->notify(eodnot);
+	}
+};
+
+IAIOResource::Writer::Writer(IOResource r, size_t sizeHint, const FlushPolicy& policy) : hint(sizeHint), flusher(new Flusher(r, policy)) {
+	flusher->slf = flusher;
+	if(hint > 0) buffer.reserve(hint);
+}
 IAIOResource::Writer::~Writer(){
-	resource->engine <<= flush() >> [res = resource, naut = eodnot](auto wr){
-		naut->completed(std::move(wr));
-		res->engine->notify(naut);
-	};
+	auto local = takeLocal();
+	std::unique_lock lok(flusher->lock);
+	flusher->pending.append(std::move(local));
+	flusher->closing = true;
+	flusher->kick();
 }
-Future<IAIOResource::WriteResult> IAIOResource::Writer::eod() const { return eodnot; }
-Future<IAIOResource::WriteResult> IAIOResource::Writer::flush(){
+Future<IAIOResource::WriteResult> IAIOResource::Writer::eod() const { return flusher->eodnot; }
+IAIOResource::Writer& IAIOResource::Writer::reserve(size_t bytes){
+	hint = std::max(hint, bytes);
+	buffer.reserve(buffer.size() + bytes);
+	return *this;
+}
+OutboundQueue IAIOResource::Writer::takeLocal(){
 	std::vector<char> buff;
 	std::swap(buff, buffer);
-	return lflush = (lflush >> [res = resource, buff](auto lr){
-		if(lr.err()) return completed(std::move(lr));
-		else return res->write(buff);
-	});
+	if(hint > 0) buffer.reserve(hint);
+	OutboundQueue q;
+	std::swap(q, queue);
+	q.push(std::move(buff));
+	return q;
+}
+Future<IAIOResource::WriteResult> IAIOResource::Writer::flush(){
+	auto local = takeLocal();
+	std::unique_lock lok(flusher->lock);
+	flusher->pending.append(std::move(local));
+	if(flusher->failed.isErr()) return completed(WriteResult(flusher->failed));
+	if(!flusher->writing && flusher->pending.empty()) return completed(WriteResult::Ok());
+	auto n = std::make_shared<OutsideFuture<WriteResult>>();
+	flusher->waiting.push_back(n);
+	flusher->kick();
+	return n;
+}
+bool IAIOResource::Writer::congested(){
+	if(flusher->policy.highWater == 0) return false;
+	std::unique_lock lok(flusher->lock);
+	return buffer.size() + queue.size() + flusher->buffered() >= flusher->policy.highWater;
+}
+Future<IAIOResource::WriteResult> IAIOResource::Writer::ready(){
+	if(!congested()) return completed(WriteResult::Ok());
+	auto local = takeLocal();
+	std::unique_lock lok(flusher->lock);
+	flusher->pending.append(std::move(local));
+	if(flusher->failed.isErr()) return completed(WriteResult(flusher->failed));
+	flusher->kick();
+	if(flusher->buffered() <= flusher->policy.lowWater) return completed(WriteResult::Ok());
+	auto n = std::make_shared<OutsideFuture<WriteResult>>();
+	flusher->drains.push_back(n);
+	return n;
+}
+IAIOResource::Writer& IAIOResource::Writer::write(WriteBuffer&& data){
+	if(!buffer.empty()){
+		queue.push(std::move(buffer));
+		buffer = std::vector<char>();
+	}
+	queue.push(std::move(data));
+	return *this;
 }
 
-IORWriter IAIOResource::writer(){
-	return IORWriter(new Writer(slf.lock()));
+IORWriter IAIOResource::writer(size_t sizeHint, const FlushPolicy& policy){
+	return IORWriter(new Writer(slf.lock(), sizeHint, policy));
+}
+
+Future<PipeReport> IAIOResource::_pipeTo(const IOResource& dst, const PipeOptions& options){
+	struct HandOff {
+		IORWriter wr;
+		PipeReport report;
+		/// Written out as confirmed by flushes, shared with their continuations
+		std::shared_ptr<std::atomic<uint64_t>> written;
+		std::optional<Future<ReadResult>> rd;
+		std::optional<Future<WriteResult>> wait;
+		bool eod;
+	};
+	FlushPolicy policy;
+	policy.highWater = std::max<size_t>(options.maxInFlight, 1);
+	policy.lowWater = policy.highWater / 2;
+	return defer(lambdagen([this, self = slf.lock(), limit = options.limit](const Yengine*, bool& done, HandOff& h) -> Generesume<PipeReport> {
+		auto finish = [&](std::optional<SysError> error){
+			done = true;
+			if(!h.report.error) h.report.error = error;
+			h.report.written = h.report.error ? h.written->load() : h.report.read;
+			return std::move(h.report);
+		};
+		if(h.wait){
+			auto res = h.wait->result();
+			h.wait = std::nullopt;
+			if(auto err = res.err()) return finish(*err);
+			if(h.eod) return finish(std::nullopt);
+		}
+		if(h.rd){
+			auto res = h.rd->result();
+			h.rd = std::nullopt;
+			if(auto err = res.err()){
+				//write out what got through, and report the read failure
+				h.report.error = *err;
+				h.eod = true;
+				return *(h.wait = h.wr->flush());
+			}
+			auto data = std::move(*res.ok());
+			if(limit > 0 && h.report.read + data.size() >= limit){
+				if(h.report.read + data.size() > limit){ //the surplus stays for whoever reads next
+					size_t keep = limit - h.report.read;
+					readbuff.insert(readbuff.begin(), data.begin()+keep, data.end());
+					data.resize(keep);
+				}
+				h.eod = true;
+			}
+			if(data.empty()) h.eod = true;
+			else {
+				auto n = data.size();
+				h.report.read += n;
+				h.wr->write(WriteBuffer(std::move(data)));
+				self->engine <<= h.wr->flush() >> [written = h.written, n](WriteResult r){
+					if(r.isOk()) *written += n;
+				};
+			}
+			if(h.eod) return *(h.wait = h.wr->flush());
+			if(h.wr->congested()) return *(h.wait = h.wr->ready());
+		}
+		return *(h.rd = readSome<std::vector<char>>());
+	}, HandOff{dst->writer(0, policy), PipeReport(), std::make_shared<std::atomic<uint64_t>>(0), std::nullopt, std::nullopt, false}));
 }
 
 
 // IO Yengine
 
-IOYengine::IOYengine(Yengine* e) : engine(e),
+IOYengine::IOYengine(Yengine* e, const BlockingPoolConfig& fio) : engine(e),
 	#ifdef _WIN32
-	ioPo(new StandardHandledResource(CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, ioThreads)))
+	ioPo(new StandardHandledResource(CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, ioThreads))),
 	#else
-	ioPo(new StandardHandledResource(::epoll_create1(EPOLL_CLOEXEC)))
+	ioPo(new StandardHandledResource(::epoll_create1(EPOLL_CLOEXEC))),
 	#endif
+	fileIO(fio)
 {
 	#ifdef _WIN32
 	#else
@@ -397,6 +1322,7 @@ void IOYengine::wioe(){
 		std::unique_lock lok(ticketsLock);
 		while(tickets > 0) condWIOE.wait(lok);
 	}
+	fileIO.shutdown();
 	#ifdef _WIN32
 	for(unsigned i = 0; i < ioThreads; i++) PostQueuedCompletionStatus(ioPo->rh, 0, COMPLETION_KEY_SHUTDOWN, NULL);
 	#else
@@ -472,10 +1398,10 @@ FileOpenResult fileOpenRead(IOYengine* engine, const std::string& path){
 	ResourceHandle file;
 	#ifdef _WIN32
 	file = CreateFileA(path.c_str(), GENERIC_READ, 0, NULL, OPEN_ALWAYS, FILE_FLAG_OVERLAPPED/* | FILE_FLAG_NO_BUFFERING cf https://docs.microsoft.com/en-us/windows/win32/fileio/file-buffering?redirectedfrom=MSDN */, NULL);
-	if(file == INVALID_HANDLE_VALUE) retSysError<FileOpenResult>("Open File failed", GetLastError());
+	if(file == INVALID_HANDLE_VALUE) return retSysError<FileOpenResult>("Open File failed", GetLastError());
 	#else
 	file = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
-	if(file < 0) retSysError<FileOpenResult>("Open file failed", errno);
+	if(file < 0) return retSysError<FileOpenResult>("Open file failed", errno);
 	#endif
 	return engine->taek(HandledResource(new StandardHandledResource(file)));
 }
@@ -483,10 +1409,10 @@ FileOpenResult fileOpenWrite(IOYengine* engine, const std::string& path){
 	ResourceHandle file;
 	#ifdef _WIN32
 	file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_FLAG_OVERLAPPED, NULL);
-	if(file == INVALID_HANDLE_VALUE) retSysError<FileOpenResult>("Open File failed", GetLastError());
+	if(file == INVALID_HANDLE_VALUE) return retSysError<FileOpenResult>("Open File failed", GetLastError());
 	#else
 	file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
-	if(file < 0) retSysError<FileOpenResult>("Open file failed", errno);
+	if(file < 0) return retSysError<FileOpenResult>("Open file failed", errno);
 	#endif
 	return engine->taek(HandledResource(new StandardHandledResource(file)));
 }
@@ -10,7 +10,11 @@
 #include "util.hpp"
 #include "impls.hpp"
 #include "syserr.hpp"
+#include "ticktack.hpp"
+#include "blocking.hpp"
 #include <sstream>
+#include <string_view>
+#include <charconv>
 
 using fd_t = int;
 #ifdef _WIN32
@@ -19,6 +23,7 @@ using fd_t = int;
 #include <windows.h>
 using ResourceHandle = HANDLE;
 #else
+#include <sys/uio.h>
 using ResourceHandle = fd_t;
 #endif
 
@@ -38,6 +43,11 @@ class IHandledResource {
 		bool iopor;
 		IHandledResource(ResourceHandle r, bool iopor = false);
 		virtual ~IHandledResource() = 0;
+		/**
+		 * Gives the handle up, to be owned elsewhere: it is left open when the resource goes
+		 * @returns whether the handle could be given up
+		 */
+		virtual bool detach();
 };
 using HandledResource = std::unique_ptr<IHandledResource>;
 using SharedResource = std::shared_ptr<IHandledResource>;
@@ -81,23 +91,237 @@ class IResource {
 		 * Implementations reserve the right to cancel underlying IO or simply detach at their discretion. 
 		 */
 		virtual void cancel() = 0;
+		/**
+		 * Marks the operations started so far, see cancelMarked
+		 */
+		virtual uint64_t operationMark(){ return 0; }
+		/**
+		 * Cancels the current IO operation, asynchronously, only if it started after the mark.
+		 * If it completed meanwhile, this is no-op - the cancellation never carries over to the next operation.
+		 * Defaults to cancel() for resources that can't tell their operations apart.
+		 * @param mark operationMark() from before the operation started
+		 */
+		virtual void cancelMarked(uint64_t){ cancel(); }
 };
 
 class IAIOResource;
 using IOResource = std::shared_ptr<IAIOResource>;
 
+/**
+ * View of immutable data, kept alive by its owner (a mapping for example)
+ */
+struct SharedView {
+	std::shared_ptr<const void> owner;
+	std::string_view data;
+};
+
+/**
+ * Data to be written out.
+ * Either owns the data (moved in), shares immutable data, or borrows static data.
+ */
+class WriteBuffer {
+	public:
+		using Storage = std::variant<std::vector<char>, std::string, std::shared_ptr<const std::vector<char>>, std::shared_ptr<const std::string>, std::string_view, SharedView>;
+	private:
+		Storage storage;
+		struct Borrow {};
+		WriteBuffer(Borrow, std::string_view data) : storage(data) {}
+	public:
+		WriteBuffer() = default;
+		WriteBuffer(std::vector<char>&& data) : storage(std::move(data)) {}
+		WriteBuffer(std::string&& data) : storage(std::move(data)) {}
+		WriteBuffer(std::shared_ptr<const std::vector<char>> data) : storage(std::move(data)) {}
+		WriteBuffer(std::shared_ptr<const std::string> data) : storage(std::move(data)) {}
+		WriteBuffer(SharedView data) : storage(std::move(data)) {}
+		WriteBuffer(WriteBuffer&&) = default;
+		WriteBuffer& operator=(WriteBuffer&&) = default;
+		WriteBuffer(const WriteBuffer&) = delete;
+		WriteBuffer& operator=(const WriteBuffer&) = delete;
+		/**
+		 * Borrows the data. The data must outlive all writes of it.
+		 */
+		static inline WriteBuffer borrowed(std::string_view data){ return WriteBuffer(Borrow{}, data); }
+		const char* data() const;
+		size_t size() const;
+		inline bool empty() const { return size() == 0; }
+		/**
+		 * Takes the data as vector, copying only if it is not owned vector already
+		 */
+		std::vector<char> take() &&;
+};
+
+/**
+ * Queue of buffers to be written out, in order.
+ * Buffers are neither concatenated nor shifted - written out data is tracked by an advancing offset.
+ */
+class OutboundQueue {
+	std::vector<WriteBuffer> bufs;
+	size_t head = 0;
+	size_t off = 0;
+	size_t left = 0;
+	public:
+		OutboundQueue() = default;
+		OutboundQueue(WriteBuffer&& buf);
+		OutboundQueue(OutboundQueue&&) = default;
+		OutboundQueue& operator=(OutboundQueue&&) = default;
+		OutboundQueue(const OutboundQueue&) = delete;
+		OutboundQueue& operator=(const OutboundQueue&) = delete;
+		/**
+		 * Enqueues the buffer at the end
+		 */
+		OutboundQueue& push(WriteBuffer&& buf);
+		/**
+		 * @returns whether there is nothing left to write
+		 */
+		inline bool empty() const { return left == 0; }
+		/**
+		 * @returns number of bytes left to write
+		 */
+		inline size_t size() const { return left; }
+		/**
+		 * @returns remainder of the first buffer
+		 */
+		inline const char* frontData() const { return bufs[head].data() + off; }
+		inline size_t frontSize() const { return bufs[head].size() - off; }
+		/**
+		 * Marks the number of bytes as written out, releasing fully written buffers
+		 * @param keep keep written buffers in place instead, for the kernel still reading them (zero-copy sends)
+		 */
+		void advance(size_t bytes, bool keep = false);
+		#ifndef _WIN32
+		/**
+		 * Fills the io vector with what's left to write
+		 * @returns number of io vector entries used
+		 */
+		size_t gather(::iovec* iov, size_t max) const;
+		#endif
+		/**
+		 * Enqueues what's left to write in the other queue at the end
+		 */
+		OutboundQueue& append(OutboundQueue&& other);
+		/**
+		 * Collapses what's left to write into a single buffer
+		 */
+		std::vector<char> concat() &&;
+};
+
+/**
+ * How a writer pushes flushed data out.
+ * Data flushed while a write is outstanding is always merged into the next single write.
+ */
+struct FlushPolicy {
+	/// Number of buffered (flushed but not yet written out) bytes at or above which the writer is congested. 0 for unbounded.
+	size_t highWater = 0;
+	/// Number of buffered bytes at or below which the congestion is relieved
+	size_t lowWater = 0;
+	/// Flushed data is held back until there's at least this many bytes, or `corkDelay` passes, so that small flushes go out together. Their futures complete once it's written. 0 to never hold back. The last flush (letting the writer go) is never held back, and the threshold is capped at `highWater`.
+	size_t corkBytes = 0;
+	/// Timer releasing held back data after `corkDelay`. Nothing is held back without it.
+	TickTack* corkTimer = nullptr;
+	TickTack::Duration corkDelay = std::chrono::milliseconds(1);
+	/// Corks the socket (TCP_CORK) while writes follow one another, so only full segments go out, and uncorks once everything flushed is written
+	bool tcpCork = false;
+};
+
+/**
+ * How a resource is piped into another
+ */
+struct PipeOptions {
+	/// Most bytes read from the source but not yet written to the destination
+	size_t maxInFlight = 1 << 16;
+	/// Number of bytes to forward, 0 till EOD of the source
+	uint64_t limit = 0;
+};
+
+struct PipeReport {
+	/// Bytes read from the source
+	uint64_t read = 0;
+	/// Bytes written to the destination
+	uint64_t written = 0;
+	/// First error, on either side
+	std::optional<SysError> error = std::nullopt;
+};
+
+struct ZeroCopyStats {
+	/// Sends without copying, and sends copied as usual (below the threshold, or out of memory to pin the data)
+	unsigned long long sent = 0, small = 0;
+	/// Sends the kernel is done with - without copying, or copied after all
+	unsigned long long zeroCopied = 0, copied = 0;
+	/// Writes whose buffers are held for sends the kernel isn't done with yet
+	size_t held = 0;
+};
+
+/**
+ * Bound on how long an operation may take
+ */
+struct Deadline {
+	TickTack* timer;
+	/// From when the operation is requested, `0` for unbounded
+	TickTack::Duration timeout;
+};
+
+/**
+ * Bounds the operation: once the timeout passes, the operation is cancelled and completes with a timeout error.
+ * Only the operation itself is cancelled (see IResource::cancelMarked), one completing as the timeout passes keeps its result.
+ * Arming and disarming is a timer insertion and removal, cheap enough for every operation.
+ * @param resource resource the operation runs on, it is not kept alive by the deadline
+ * @param op `result<…, SysError>`, not started yet
+ */
+template<typename R> Future<R> withDeadline(std::weak_ptr<IResource> resource, Future<R> op, const Deadline& deadline){
+	if(!deadline.timer || deadline.timeout <= TickTack::Duration::zero()) return op;
+	struct Guard {
+		std::mutex lock;
+		bool done = false, fired = false;
+	};
+	auto guard = std::make_shared<Guard>();
+	auto timer = deadline.timer;
+	uint64_t mark = 0;
+	if(auto r = resource.lock()) mark = r->operationMark();
+	auto id = timer->after(deadline.timeout, [guard, resource, mark](TickTack::Id, bool cancelled){
+		if(cancelled) return;
+		std::unique_lock lok(guard->lock);
+		if(guard->done) return;
+		guard->fired = true;
+		if(auto r = resource.lock()) r->cancelMarked(mark);
+	});
+	return op >> [guard, timer, id](R r){
+		bool fired;
+		{
+			std::unique_lock lok(guard->lock);
+			guard->done = true;
+			fired = guard->fired;
+		}
+		if(!fired) timer->stop(id);
+		else if(r.isErr()) return R::Err("Operation timed out");
+		return r;
+	};
+}
+
 template<typename T> auto mapVecToT(){
 	if constexpr (std::is_same<T, std::vector<char>>::value) return [](auto r){ return r; };
-	else return [](auto rr){ return rr.mapOk([](auto v){ return T(v.begin(), v.end()); }); };
+	else return [](auto rr){ return std::move(rr).mapOk([](std::vector<char>&& v){ return T(v.begin(), v.end()); }); };
 }
 
+/**
+ * Custom formatting for writers.
+ * Specialize with `void operator()(IAIOResource::Writer&, const T&) const` to append `T` straight into the writer.
+ * Types without specialization (or fast path) are formatted through `std::ostream`.
+ */
+template<typename T, typename = void> struct WriterFormat {};
+
+template<typename T, typename W, typename = std::void_t<>> struct has_writer_format : std::false_type {};
+template<typename T, typename W> struct has_writer_format<T, W, std::void_t<decltype(WriterFormat<T>{}(std::declval<W&>(), std::declval<const T&>()))>> : std::true_type {};
+
+template<typename T> constexpr bool is_writer_char = std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value;
+template<typename T> constexpr bool is_writer_number = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !is_writer_char<T> && !std::is_same<T, wchar_t>::value && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value;
+
 class IAIOResource : public IResource {
 	protected:
 		IAIOResource(Yengine* e) : engine(e){}
 		std::weak_ptr<IAIOResource> slf;
 		auto setSelf(std::shared_ptr<IAIOResource> self){ return slf = self; }
 	public:
-		using ReadResult = result<std::vector<char>, std::string>;
+		using ReadResult = result<std::vector<char>, SysError>;
 		/**
 		 * Reads _at least_ the number of bytes requested, or until EOD is reached.
 		 * If no bytes are requested, read until EOD.
@@ -107,13 +331,86 @@ class IAIOResource : public IResource {
 		 * @returns result of the read
 		 */
 		virtual Future<ReadResult> _read(size_t bytes = 0) = 0;
-		using WriteResult = result<void, std::string>;
+		using WriteResult = result<void, SysError>;
 		/**
 		 * Writes the data to the resource.
 		 * @param data data to write
 		 * @returns result of the write
 		 */
 		virtual Future<WriteResult> _write(std::vector<char>&& data) = 0;
+		/**
+		 * Writes all the data in the queue to the resource.
+		 * Resources capable of gathering write do so, otherwise the queue is collapsed and written in one go.
+		 * @param data data to write
+		 * @returns result of the write
+		 */
+		virtual Future<WriteResult> _writev(OutboundQueue&& data);
+		/**
+		 * Reads the number of bytes at the position, leaving the stream position be.
+		 * Fewer bytes are returned only if EOF is reached.
+		 * Resources without positions (pipes, sockets...) error.
+		 * @param offset position to read from
+		 * @param bytes number of bytes to read
+		 * @returns result of the read
+		 */
+		virtual Future<ReadResult> _readAt(uint64_t offset, size_t bytes);
+		/**
+		 * Writes all the data at the position, leaving the stream position be.
+		 * Resources without positions (pipes, sockets...) error.
+		 * @param offset position to write at
+		 * @param data data to write
+		 * @returns result of the write
+		 */
+		virtual Future<WriteResult> _writeAt(uint64_t offset, OutboundQueue&& data);
+		using SendResult = result<uint64_t, SysError>;
+		/**
+		 * Writes a part of the file to the resource.
+		 * Resources able to, send it without passing the data through user space, otherwise the file is copied over in chunks with positional reads.
+		 * @param file positional resource to send from
+		 * @param offset position in the file
+		 * @param length number of bytes to send, `0` till EOF
+		 * @returns number of bytes sent, fewer than requested only if EOF is reached
+		 */
+		virtual Future<SendResult> _sendFile(const IOResource& file, uint64_t offset, uint64_t length);
+		/**
+		 * Underlying system handle, if there is one
+		 */
+		virtual std::optional<ResourceHandle> handle() const { return std::nullopt; }
+		/**
+		 * Gives the underlying handle up, to hand a connection over to another process for example. The resource is unusable after.
+		 * @returns the handle, owned by the caller from then on, if it could be given up
+		 */
+		virtual std::optional<ResourceHandle> detach(){ return std::nullopt; }
+		/**
+		 * Cancels the operation waiting on the resource once no data has moved for the duration, so that a stalled peer fails it with a timeout error.
+		 * Checked once per period rather than per operation. While no operation waits there's nothing to cancel, and the watch goes on. `0` stops the watch
+		 * @returns whether the resource keeps track of its activity
+		 */
+		virtual bool idleTimeout(TickTack*, TickTack::Duration){ return false; }
+		/**
+		 * Holds partial segments back until uncorked (TCP_CORK)
+		 * @returns whether the resource can be corked
+		 */
+		virtual bool cork(bool){ return false; }
+		/**
+		 * Sends writes of at least the threshold without copying the data into the kernel (MSG_ZEROCOPY).
+		 * The data is held until the kernel reports being done with it. Pays off for large writes only, and the kernel may copy anyway (loopback for one).
+		 * @param threshold smallest write sent without copying, `0` to turn it off
+		 * @returns whether the resource can send without copying
+		 */
+		virtual bool zeroCopy(size_t){ return false; }
+		virtual ZeroCopyStats zeroCopyStats(){ return ZeroCopyStats(); }
+		/**
+		 * Forwards data from this resource to the destination, until EOD (or limit) or the first error.
+		 * The default hands read buffers over to a writer of the destination, pausing reads while it is congested.
+		 * @param dst resource to write to
+		 * @param options bounds
+		 * @returns byte counts and the first error
+		 */
+		virtual Future<PipeReport> _pipeTo(const IOResource& dst, const PipeOptions& options);
+	protected:
+		/// Whether there is read data buffered (by peek or pattern read) that hasn't been consumed yet
+		inline bool buffered() const { return !readbuff.empty(); }
 	private:
 		std::vector<char> readbuff;
 	public:
@@ -122,13 +419,13 @@ class IAIOResource : public IResource {
 		/**
 		 * Reads until EOD.
 		 */
-		template<typename T> Future<result<T, std::string>> read(){
+		template<typename T> Future<result<T, SysError>> read(){
 			return read<std::vector<char>>() >> mapVecToT<T>();
 		}
 		/**
 		 * Reads up to number of bytes, or EOD.
 		 */
-		template<typename T> Future<result<T, std::string>> read(size_t upto){
+		template<typename T> Future<result<T, SysError>> read(size_t upto){
 			return read<std::vector<char>>(upto) >> mapVecToT<T>();
 		}
 		template<typename PatIt> Future<ReadResult> read_(const PatIt& patBegin, const PatIt& patEnd);
@@ -136,19 +433,35 @@ class IAIOResource : public IResource {
 		 * Reads until reaching the pattern. Pattern is included in and is the last sequence of the result.
 		 * If the EOF is reached and pattern not met, errors appropriately.
 		 */
-		template<typename T, typename PatIt> Future<result<T, std::string>> read(const PatIt& patBegin, const PatIt& patEnd){
+		template<typename T, typename PatIt> Future<result<T, SysError>> read(const PatIt& patBegin, const PatIt& patEnd){
 			return read_<PatIt>(patBegin, patEnd) >> mapVecToT<T>();
 		}
-		template<typename T> Future<result<T, std::string>> read(const std::string& pattern){
+		template<typename T> Future<result<T, SysError>> read(const std::string& pattern){
 			return read<T>(pattern.begin(), pattern.end());
 		}
+		/**
+		 * Reads whatever is available.
+		 * If there is buffered data, it is returned without performing IO. Otherwise reads one optimal buffer unit.
+		 * Empty result indicates EOD.
+		 */
+		template<typename T> Future<result<T, SysError>> readSome(){
+			return readSome<std::vector<char>>() >> mapVecToT<T>();
+		}
+		/**
+		 * Reads the number of bytes at the position, or up to EOF.
+		 * Positional reads bypass the stream (and its buffer), any number of them may be outstanding at once.
+		 */
+		template<typename T> Future<result<T, SysError>> readAt(uint64_t offset, size_t bytes){
+			if constexpr (std::is_same<T, std::vector<char>>::value) return _readAt(offset, bytes);
+			else return _readAt(offset, bytes) >> mapVecToT<T>();
+		}
 
 		/**
 		 * Peeks up to number of bytes, or EOD.
 		 * Like reading, if enough data is available in the buffer no IO is performed.
 		 * Unlike reading, peeking does not consume the data (and thus leaves / adds it to the buffer).
 		 */
-		template<typename T> Future<result<T, std::string>> peek(size_t upto){
+		template<typename T> Future<result<T, SysError>> peek(size_t upto){
 			return peek<std::vector<char>>(upto) >> mapVecToT<T>();
 		}
 
@@ -168,25 +481,98 @@ class IAIOResource : public IResource {
 		 * Writes data
 		 */
 		template<typename Range> Future<WriteResult> write(const Range& dataRange){
-			return write(std::vector<char>(dataRange.begin(), dataRange.end()));
+			if constexpr (std::is_constructible<WriteBuffer, const Range&>::value) return _writev(OutboundQueue(WriteBuffer(dataRange)));
+			else return write(std::vector<char>(dataRange.begin(), dataRange.end()));
 		}
+		/**
+		 * Writes data.
+		 * Moved in strings and vectors, as well as shared buffers, are written without copying.
+		 */
 		template<typename Range> Future<WriteResult> write(Range && dataRange){
-			return write(std::vector<char>(dataRange.begin(), dataRange.end()));
+			if constexpr (std::is_constructible<WriteBuffer, Range&&>::value) return _writev(OutboundQueue(WriteBuffer(std::forward<Range>(dataRange))));
+			else return write(std::vector<char>(dataRange.begin(), dataRange.end()));
+		}
+		/**
+		 * Writes static data without copying.
+		 * The data must outlive the write.
+		 */
+		Future<WriteResult> writeStatic(std::string_view data){
+			return _writev(OutboundQueue(WriteBuffer::borrowed(data)));
+		}
+		/**
+		 * Writes data at the position.
+		 * Positional writes bypass the stream, any number of them may be outstanding at once.
+		 */
+		template<typename Range> Future<WriteResult> writeAt(uint64_t offset, Range && dataRange){
+			if constexpr (std::is_constructible<WriteBuffer, Range&&>::value) return _writeAt(offset, OutboundQueue(WriteBuffer(std::forward<Range>(dataRange))));
+			else return _writeAt(offset, OutboundQueue(std::vector<char>(dataRange.begin(), dataRange.end())));
+		}
+		/**
+		 * Forwards data to the destination, see _pipeTo.
+		 * Neither resource should be otherwise read from nor written to meanwhile.
+		 */
+		Future<PipeReport> pipeTo(const IOResource& dst, const PipeOptions& options = PipeOptions()){
+			return _pipeTo(dst, options);
+		}
+		/**
+		 * Sends a part of the file, see _sendFile.
+		 * Data buffered in writers is not flushed beforehand.
+		 */
+		Future<SendResult> sendFile(const IOResource& file, uint64_t offset = 0, uint64_t length = 0){
+			return _sendFile(file, offset, length);
+		}
+		/**
+		 * Writes all the buffers, in order, without concatenating them
+		 */
+		Future<WriteResult> writev(OutboundQueue&& data){
+			return _writev(std::move(data));
+		}
+		/**
+		 * Writes all the buffers, in order, without concatenating them
+		 */
+		template<typename... Bufs> Future<WriteResult> writev(WriteBuffer&& buf, Bufs&&... bufs){
+			OutboundQueue q(std::move(buf));
+			(q.push(std::forward<Bufs>(bufs)), ...);
+			return _writev(std::move(q));
+		}
+		/**
+		 * Bounds an operation on this resource, see withDeadline
+		 */
+		template<typename R> Future<R> within(Future<R> op, const Deadline& deadline){
+			return withDeadline<R>(slf, std::move(op), deadline);
+		}
+		template<typename T> Future<result<T, SysError>> read(const Deadline& deadline){
+			return within(read<T>(), deadline);
+		}
+		template<typename T> Future<result<T, SysError>> read(size_t upto, const Deadline& deadline){
+			return within(read<T>(upto), deadline);
+		}
+		template<typename T> Future<result<T, SysError>> read(const std::string& pattern, const Deadline& deadline){
+			return within(read<T>(pattern), deadline);
+		}
+		template<typename T> Future<result<T, SysError>> readSome(const Deadline& deadline){
+			return within(readSome<T>(), deadline);
+		}
+		template<typename Range> Future<WriteResult> write(Range && dataRange, const Deadline& deadline){
+			return within(write(std::forward<Range>(dataRange)), deadline);
 		}
 		//L2
 		/**
 		 * (Lazy?) Stream-like writer.
 		 * The data is accumulated locally.
 		 * The data can be flushed at any intermediate point.
+		 * At most one write is outstanding at a time, everything flushed meanwhile goes out together in the next one.
 		 * Letting writer go incurs the last flush and the eod can be fullfilled.
 		 */
 		class Writer {
-			IOResource resource;
+			struct Flusher;
 			std::vector<char> buffer;
-			std::shared_ptr<OutsideFuture<WriteResult>> eodnot;
-			Future<WriteResult> lflush;
+			size_t hint;
+			OutboundQueue queue;
+			std::shared_ptr<Flusher> flusher;
+			OutboundQueue takeLocal();
 			public:
-				Writer(IOResource resource);
+				Writer(IOResource resource, size_t sizeHint = 0, const FlushPolicy& policy = FlushPolicy());
 				~Writer();
 				Writer(const Writer& cpy) = delete;
 				Writer(Writer && mv) = delete;
@@ -197,31 +583,88 @@ class IAIOResource : public IResource {
 				/**
 				 * Flushes intermediate data [_proactively_!].
 				 * The writer can still be used after the flush.
+				 * @returns future that completes when all the data flushed so far is written out
 				 */
 				Future<WriteResult> flush();
+				/**
+				 * Backpressure.
+				 * If the writer is congested (above high water mark), flushes and waits until it drains down to the low water mark.
+				 * @returns future that completes when the producer can go on
+				 */
+				Future<WriteResult> ready();
+				/**
+				 * @returns whether the writer is at or above the high water mark
+				 */
+				bool congested();
 				template<typename DataIt> Writer& write(const DataIt& dataBegin, const DataIt& dataEnd){
 					buffer.insert(buffer.end(), dataBegin, dataEnd);
 					return *this;
 				}
 				template<typename DataRange> Writer& write(const DataRange& range){
-					return write(range.begin(), range.end());
+					if constexpr (std::is_constructible<WriteBuffer, const DataRange&>::value) return write(WriteBuffer(range));
+					else return write(range.begin(), range.end());
 				}
-				template<typename Data> Writer& operator<<(const Data& d){
-					std::ostringstream buff;
-					buff << d;
-					write(buff.str());
+				/**
+				 * Enqueues the data as is, without copying it into the writer's buffer.
+				 */
+				Writer& write(WriteBuffer&& data);
+				/**
+				 * Reserves buffer space for at least the number of bytes more.
+				 * The hint is kept and the buffer is pre-reserved again after each flush.
+				 */
+				Writer& reserve(size_t bytes);
+				inline size_t capacity() const { return buffer.capacity(); }
+				inline size_t size() const { return buffer.size(); }
+				inline Writer& append(std::string_view d){
+					buffer.insert(buffer.end(), d.begin(), d.end());
 					return *this;
 				}
+				inline Writer& append(char c){
+					buffer.push_back(c);
+					return *this;
+				}
+				/**
+				 * Appends the number as text, without going through streams.
+				 * Floating point numbers are formatted like default `std::ostream` does (general, precision 6).
+				 */
+				template<typename Num> Writer& appendNumber(Num n){
+					std::array<char, 64> tmp;
+					std::to_chars_result res;
+					if constexpr (std::is_floating_point<Num>::value) res = std::to_chars(tmp.data(), tmp.data()+tmp.size(), n, std::chars_format::general, 6);
+					else res = std::to_chars(tmp.data(), tmp.data()+tmp.size(), n);
+					buffer.insert(buffer.end(), tmp.data(), res.ptr);
+					return *this;
+				}
+				/**
+				 * Appends the thing formatted as text.
+				 * Characters, strings, numbers and types with WriterFormat are appended directly, others go through `std::ostream`.
+				 */
+				template<typename Data> Writer& operator<<(const Data& d){
+					if constexpr (is_writer_char<Data>) return append(static_cast<char>(d));
+					else if constexpr (std::is_same<Data, bool>::value) return append(d ? '1' : '0');
+					else if constexpr (is_writer_number<Data>) return appendNumber(d);
+					else if constexpr (std::is_convertible<const Data&, std::string_view>::value) return append(std::string_view(d));
+					else if constexpr (has_writer_format<Data, Writer>::value){
+						WriterFormat<Data>{}(*this, d);
+						return *this;
+					} else {
+						std::ostringstream buff;
+						buff << d;
+						return append(buff.str());
+					}
+				}
 		};
 		/**
 		 * Creates a new [lazy] (text) writer for the resource
 		 */
-		std::shared_ptr<Writer> writer();
+		std::shared_ptr<Writer> writer(size_t sizeHint = 0, const FlushPolicy& policy = FlushPolicy());
 };
 
 template<> Future<IAIOResource::ReadResult> IAIOResource::read<std::vector<char>>();
 template<> Future<IAIOResource::ReadResult> IAIOResource::read<std::vector<char>>(size_t upto);
 
+template<> Future<IAIOResource::ReadResult> IAIOResource::readSome<std::vector<char>>();
+
 template<> Future<IAIOResource::ReadResult> IAIOResource::peek<std::vector<char>>(size_t upto);
 
 template<typename PatIt> Future<IAIOResource::ReadResult> IAIOResource::read_(const PatIt& patBegin, const PatIt& patEnd){
@@ -241,7 +684,7 @@ template<typename PatIt> Future<IAIOResource::ReadResult> IAIOResource::read_(co
 					done = true;
 					return IAIOResource::ReadResult::Err(*err);
 				}
-				auto rd = *res.ok();
+				auto rd = std::move(*res.ok());
 				if(rd.empty()){
 					done = true;
 					return IAIOResource::ReadResult::Err("Reached EOF and didn't meet pattern!");
@@ -276,14 +719,30 @@ template<typename Data> decltype(auto) operator<<(const IORWriter& wr, const Dat
 	return wr;
 }
 
+/**
+ * Forwards data from the source to the destination, with bounded number of bytes in flight.
+ * @see IAIOResource::_pipeTo
+ */
+inline Future<PipeReport> pipeTo(const IOResource& src, const IOResource& dst, const PipeOptions& options = PipeOptions()){
+	return src->pipeTo(dst, options);
+}
+
 class IOYengine {
 	public:
 		Yengine* const engine;
-		IOYengine(Yengine* e);
+		/**
+		 * @param e engine to notify
+		 * @param fileIO pool for descriptors that can not be polled (regular files)
+		 */
+		IOYengine(Yengine* e, const BlockingPoolConfig& fileIO = BlockingPoolConfig());
 		void wioe();
 		// result<void, int> iocplReg(ResourceHandle r, bool rearm); as much as we'd love to do that, there simply waay to many differences between IOCompletion and EPoll
 		//so let's make platform specific internals public instead ¯\_(ツ)_/¯
 		SharedResource const ioPo;
+		/**
+		 * Blocking reads and writes of descriptors that are always "ready" (regular files) run here, instead of on the engine workers
+		 */
+		BlockingPool fileIO;
 		/**
 		 * Opens asynchronous IO on the handled resource.
 		 * @param r @consumes
@@ -324,7 +783,7 @@ class IOYengine {
 		std::array<std::thread, ioThreads> workers;
 };
 
-using FileOpenResult = result<IOResource, std::string>;
+using FileOpenResult = result<IOResource, SysError>;
 FileOpenResult fileOpenRead(IOYengine*, const std::string& path);
 FileOpenResult fileOpenWrite(IOYengine*, const std::string& path);
 
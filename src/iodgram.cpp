@@ -0,0 +1,253 @@
+#include "iodgram.hpp"
+
+#ifndef _WIN32
+
+#include <deque>
+#include <cstring>
+#include <netinet/udp.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+constexpr size_t GRO_MAX_SIZE = 1 << 16;
+constexpr unsigned GSO_MAX_SEGMENTS = 64;
+constexpr size_t GSO_MAX_SIZE = 65000;
+
+namespace yasync::io {
+
+Datagram::Datagram(const ::sockaddr* to, ::socklen_t length, std::vector<char>&& d) : peerLength(std::min<::socklen_t>(length, sizeof(peer))), data(std::move(d)) {
+	std::memcpy(&peer, to, peerLength);
+}
+bool Datagram::samePeer(const Datagram& other) const {
+	return peerLength == other.peerLength && std::memcmp(&peer, &other.peer, peerLength) == 0;
+}
+
+DatagramSocket::DatagramSocket(IOYengine* e, fd_t s, const DatagramOptions& o) : ReadinessSocket(e, s), options(o), gso(o.gso) {}
+
+DatagramSocket::OpenResult DatagramSocket::open(IOYengine* engine, const NetworkedAddressInfo* bindTo, const DatagramOptions& opts){
+	auto options = opts;
+	options.batch = std::max(options.batch, 1u);
+	fd_t sock = -1;
+	for(auto candidate = bindTo->addresses; candidate; candidate = candidate->ai_next){
+		sock = ::socket(candidate->ai_family, candidate->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, candidate->ai_protocol);
+		if(sock < 0) continue;
+		if(::bind(sock, candidate->ai_addr, candidate->ai_addrlen) == 0) break;
+		::close(sock);
+		sock = -1;
+	}
+	if(sock < 0) return OpenResult::Err("Exhausted address space");
+	int on = 1;
+	//best effort, older kernels have neither
+	if(options.gro && ::setsockopt(sock, SOL_UDP, UDP_GRO, &on, sizeof(on)) < 0) options.gro = false;
+	if(options.gro) options.maxSize = GRO_MAX_SIZE;
+	if(options.gso){
+		int seg = 0;
+		::socklen_t sl = sizeof(seg);
+		if(::getsockopt(sock, SOL_UDP, UDP_SEGMENT, &seg, &sl) < 0) options.gso = false;
+	}
+	auto ds = std::shared_ptr<DatagramSocket>(new DatagramSocket(engine, sock, options));
+	ds->slf = ds;
+	if(auto err = ds->poll().err()) return OpenResult::Err(*err);
+	return OpenResult::Ok(ds);
+}
+
+DatagramSocket::ConnectResult DatagramSocket::connect(const ::sockaddr* to, ::socklen_t length){
+	if(::connect(sock, to, length) < 0) return retSysNetError<ConnectResult>("connect failed");
+	return ConnectResult::Ok();
+}
+
+/**
+ * Socket → Datagram?..
+ * Receives a batch per syscall, and yields it datagram by datagram before receiving again.
+ */
+class DatagramReceiver : public IGeneratorT<Maybe<DatagramResult>> {
+	std::shared_ptr<DatagramSocket> socket;
+	size_t size;
+	std::vector<char> buff;
+	std::vector<::mmsghdr> msgs;
+	std::vector<::iovec> iov;
+	std::vector<::sockaddr_storage> peers;
+	std::vector<char> control;
+	size_t controlSize;
+	std::deque<Datagram> received;
+	std::optional<Future<int>> wait = std::nullopt;
+	bool d = false;
+	inline Maybe<DatagramResult> finish(std::optional<SysError> err){
+		d = true;
+		if(err) return Maybe<DatagramResult>(DatagramResult::Err(*err));
+		return Maybe<DatagramResult>();
+	}
+	/// Splits coalesced (GRO) datagrams back up, and marks the one cut short
+	void take(unsigned i){
+		auto& m = msgs[i].msg_hdr;
+		size_t len = msgs[i].msg_len;
+		size_t seg = 0;
+		if(m.msg_controllen > 0) for(auto c = CMSG_FIRSTHDR(&m); c; c = CMSG_NXTHDR(&m, c)) if(c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO){
+			int gs;
+			std::memcpy(&gs, CMSG_DATA(c), sizeof(gs));
+			seg = gs;
+		}
+		auto data = buff.data() + i*size;
+		auto peer = reinterpret_cast<const ::sockaddr*>(&peers[i]);
+		if(seg == 0 || seg >= len) received.emplace_back(peer, m.msg_namelen, std::vector<char>(data, data + len));
+		else for(size_t off = 0; off < len; off += seg) received.emplace_back(peer, m.msg_namelen, std::vector<char>(data + off, data + std::min(len, off + seg)));
+		//only the tail of what was received can be cut short
+		if(m.msg_flags & MSG_TRUNC) received.back().truncated = true;
+	}
+	public:
+		DatagramReceiver(std::shared_ptr<DatagramSocket> s) : socket(s), size(s->options.maxSize), buff(size * s->options.batch), msgs(s->options.batch), iov(s->options.batch), peers(s->options.batch), controlSize(CMSG_SPACE(sizeof(int))) {
+			control.resize(controlSize * s->options.batch);
+		}
+		bool done() const override { return d; }
+		Generesume<Maybe<DatagramResult>> resume(const Yengine*) override {
+			if(wait){
+				int events = wait->result();
+				wait = std::nullopt;
+				if(socket->closed) return finish(std::nullopt);
+				if(events == 0) return finish(SysError("Operation cancelled"));
+			}
+			if(!received.empty()){
+				auto dg = std::move(received.front());
+				received.pop_front();
+				return Maybe<DatagramResult>(DatagramResult::Ok(std::move(dg)));
+			}
+			while(true){
+				auto batch = msgs.size();
+				for(size_t i = 0; i < batch; i++){
+					iov[i] = {buff.data() + i*size, size};
+					auto& m = msgs[i].msg_hdr;
+					m = {};
+					m.msg_name = &peers[i];
+					m.msg_namelen = sizeof(peers[i]);
+					m.msg_iov = &iov[i];
+					m.msg_iovlen = 1;
+					if(socket->options.gro){
+						m.msg_control = control.data() + i*controlSize;
+						m.msg_controllen = controlSize;
+					}
+				}
+				auto n = ::recvmmsg(socket->sock, msgs.data(), batch, MSG_DONTWAIT, nullptr);
+				if(n > 0){
+					for(int i = 0; i < n; i++) take(i);
+					auto dg = std::move(received.front());
+					received.pop_front();
+					return Maybe<DatagramResult>(DatagramResult::Ok(std::move(dg)));
+				}
+				if(n < 0 && errno == EINTR) continue;
+				if(n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) break;
+				return finish(SysError::last("Receive failed"));
+			}
+			if(socket->closed) return finish(std::nullopt);
+			return *(wait = socket->ready(false));
+		}
+};
+
+Future<Maybe<DatagramResult>> DatagramSocket::receive(){
+	return defer(Generator<Maybe<DatagramResult>>(new DatagramReceiver(slf.lock())));
+}
+
+/**
+ * Sends the datagrams in batches, runs to the same peer coalesced when segmentation offload is on
+ */
+class DatagramSender : public IGeneratorT<DatagramSocket::SendResult> {
+	std::shared_ptr<DatagramSocket> socket;
+	std::vector<Datagram> datagrams;
+	size_t sent = 0;
+	std::vector<::mmsghdr> msgs;
+	/// Number of datagrams in each message
+	std::vector<unsigned> counts;
+	std::vector<::iovec> iov;
+	std::vector<char> control;
+	std::optional<Future<int>> wait = std::nullopt;
+	bool d = false;
+	inline DatagramSocket::SendResult finish(DatagramSocket::SendResult && r){
+		d = true;
+		return std::move(r);
+	}
+	/// Lays out messages from the first unsent datagram on
+	size_t prepare(){
+		auto batch = socket->options.batch;
+		bool gso = socket->gso.load(std::memory_order_relaxed);
+		size_t controlSize = CMSG_SPACE(sizeof(uint16_t));
+		msgs.assign(batch, ::mmsghdr{});
+		counts.assign(batch, 0);
+		iov.resize(gso ? batch*GSO_MAX_SEGMENTS : batch);
+		if(gso) control.assign(controlSize*batch, 0);
+		size_t m = 0, i = sent, v = 0;
+		for(; m < batch && i < datagrams.size(); m++){
+			auto& dg = datagrams[i];
+			auto& h = msgs[m].msg_hdr;
+			h.msg_name = dg.peerLength > 0 ? &dg.peer : nullptr;
+			h.msg_namelen = dg.peerLength;
+			h.msg_iov = &iov[v];
+			unsigned c = 0;
+			size_t seg = dg.data.size(), total = 0;
+			//all segments but the last are of the same size, the last may be shorter
+			do {
+				auto& dj = datagrams[i+c];
+				iov[v++] = {const_cast<char*>(dj.data.data()), dj.data.size()};
+				total += dj.data.size();
+				c++;
+			} while(gso && seg > 0 && c < GSO_MAX_SEGMENTS && i+c < datagrams.size() && datagrams[i+c-1].data.size() == seg && datagrams[i+c].data.size() <= seg && total + datagrams[i+c].data.size() <= GSO_MAX_SIZE && datagrams[i+c].samePeer(dg));
+			h.msg_iovlen = c;
+			if(c > 1){
+				h.msg_control = control.data() + m*controlSize;
+				h.msg_controllen = controlSize;
+				auto cm = CMSG_FIRSTHDR(&h);
+				cm->cmsg_level = SOL_UDP;
+				cm->cmsg_type = UDP_SEGMENT;
+				cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+				uint16_t gs = seg;
+				std::memcpy(CMSG_DATA(cm), &gs, sizeof(gs));
+			}
+			counts[m] = c;
+			i += c;
+		}
+		return m;
+	}
+	public:
+		DatagramSender(std::shared_ptr<DatagramSocket> s, std::vector<Datagram>&& dgs) : socket(s), datagrams(std::move(dgs)) {}
+		bool done() const override { return d; }
+		Generesume<DatagramSocket::SendResult> resume(const Yengine*) override {
+			if(wait){
+				int events = wait->result();
+				wait = std::nullopt;
+				if(socket->closed) return finish(DatagramSocket::SendResult::Err("Socket is shut down"));
+				if(events == 0) return finish(DatagramSocket::SendResult::Err("Operation cancelled"));
+			}
+			while(sent < datagrams.size()){
+				auto m = prepare();
+				auto n = ::sendmmsg(socket->sock, msgs.data(), m, MSG_DONTWAIT);
+				if(n > 0){
+					for(int j = 0; j < n; j++) sent += counts[j];
+					continue;
+				}
+				if(n < 0 && errno == EINTR) continue;
+				if(n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) return *(wait = socket->ready(true));
+				if(n < 0 && counts[0] > 1 && (errno == EIO || errno == EINVAL)){
+					//the route can't segment, send them one by one
+					socket->gso = false;
+					continue;
+				}
+				return finish(retSysError<DatagramSocket::SendResult>("Send failed"));
+			}
+			return finish(DatagramSocket::SendResult::Ok(sent));
+		}
+};
+
+Future<DatagramSocket::SendResult> DatagramSocket::send(std::vector<Datagram>&& datagrams){
+	return defer(Generator<SendResult>(new DatagramSender(slf.lock(), std::move(datagrams))));
+}
+Future<DatagramSocket::SendResult> DatagramSocket::send(Datagram&& datagram){
+	std::vector<Datagram> one;
+	one.push_back(std::move(datagram));
+	return send(std::move(one));
+}
+
+}
+
+#endif
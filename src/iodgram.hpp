@@ -0,0 +1,91 @@
+#pragma once
+
+#include "iosock.hpp"
+
+#ifndef _WIN32
+
+#include <netinet/in.h>
+
+namespace yasync::io {
+
+/**
+ * Datagram, with the peer it comes from or goes to
+ */
+struct Datagram {
+	::sockaddr_storage peer = {};
+	/// `0` for none (connected socket)
+	::socklen_t peerLength = 0;
+	std::vector<char> data;
+	/// Received longer than `maxSize`, the rest of it is lost
+	bool truncated = false;
+	Datagram() = default;
+	Datagram(const ::sockaddr* to, ::socklen_t length, std::vector<char>&& d);
+	template<typename AddressInfo> Datagram(const AddressInfo& to, std::vector<char>&& d) : Datagram(reinterpret_cast<const ::sockaddr*>(&to), sizeof(to), std::move(d)) {}
+	inline const ::sockaddr* address() const { return reinterpret_cast<const ::sockaddr*>(&peer); }
+	/// Whether both come from, or go to, the same peer
+	bool samePeer(const Datagram& other) const;
+};
+using DatagramResult = result<Datagram, SysError>;
+
+struct DatagramOptions {
+	/// Datagrams moved per syscall
+	unsigned batch = 64;
+	/// Largest datagram received, longer ones are truncated (and marked so)
+	size_t maxSize = 2048;
+	/// Let the system coalesce received datagrams of a flow (UDP_GRO), they are split up again on receipt
+	bool gro = false;
+	/// Coalesce runs of equally sized datagrams to the same peer into one send (UDP_SEGMENT)
+	bool gso = false;
+};
+
+/**
+ * Datagram (UDP) socket.
+ * Moves datagrams in batches, many per syscall (recvmmsg, sendmmsg).
+ * One receiving stream at a time, any number of sends.
+ */
+class DatagramSocket : public ReadinessSocket {
+	DatagramOptions options;
+	/// GSO in effect, off for good once a route can't segment - senders and receivers look at it concurrently
+	std::atomic<bool> gso;
+	std::weak_ptr<DatagramSocket> slf;
+	DatagramSocket(IOYengine* e, fd_t s, const DatagramOptions& o);
+	friend class DatagramReceiver;
+	friend class DatagramSender;
+	public:
+		using OpenResult = result<std::shared_ptr<DatagramSocket>, SysError>;
+		/**
+		 * Opens a socket bound to the first address that can be bound to
+		 */
+		static OpenResult open(IOYengine* engine, const NetworkedAddressInfo* bindTo, const DatagramOptions& options = DatagramOptions());
+		/**
+		 * Effective options, GRO and GSO are off if the system does not support them
+		 */
+		inline DatagramOptions settings() const {
+			auto o = options;
+			o.gso = gso;
+			return o;
+		}
+		using ConnectResult = result<void, SysError>;
+		/**
+		 * Fixes the peer: datagrams without a peer go there, and only ones from there are received
+		 */
+		ConnectResult connect(const ::sockaddr* to, ::socklen_t length);
+		template<typename AddressInfo> ConnectResult connect(const AddressInfo& to){ return connect(reinterpret_cast<const ::sockaddr*>(&to), sizeof(to)); }
+		/**
+		 * Stream of received datagrams.
+		 * Errors are yielded once and end the stream, shutdown ends it.
+		 */
+		Future<Maybe<DatagramResult>> receive();
+		using SendResult = result<size_t, SysError>;
+		/**
+		 * Sends the datagrams, in order, stopping at the first error
+		 * @returns number of datagrams sent (all of them), or the error - the datagrams before the one that failed have been sent
+		 */
+		Future<SendResult> send(std::vector<Datagram>&& datagrams);
+		Future<SendResult> send(Datagram&& datagram);
+};
+using DatagramSocketResult = DatagramSocket::OpenResult;
+
+}
+
+#endif
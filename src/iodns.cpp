@@ -0,0 +1,107 @@
+#include "iodns.hpp"
+
+#include <tuple>
+
+namespace yasync::io {
+
+bool Resolver::Key::operator<(const Key& other) const {
+	return std::tie(address, port, flags, family, socktype, protocol) < std::tie(other.address, other.port, other.flags, other.family, other.socktype, other.protocol);
+}
+
+Resolver::Resolver(const ResolverConfig& c) : config(c), pool(c.pool) {}
+
+void Resolver::prune(Clock::time_point now){
+	for(auto it = entries.begin(); it != entries.end();){
+		if(!it->second.running && it->second.expires <= now) it = entries.erase(it);
+		else ++it;
+	}
+	while(entries.size() >= std::max<size_t>(config.capacity, 1)){
+		auto soonest = entries.end();
+		for(auto it = entries.begin(); it != entries.end(); ++it) if(!it->second.running && (soonest == entries.end() || it->second.expires < soonest->second.expires)) soonest = it;
+		if(soonest == entries.end()) return; //all running, they'll settle
+		entries.erase(soonest);
+	}
+}
+
+Future<Resolver::FindResult> Resolver::find(Yengine* engine, const std::string& address, const std::string& port, const ::addrinfo& hints){
+	Key key{address, port, hints.ai_flags, hints.ai_family, hints.ai_socktype, hints.ai_protocol};
+	auto f = std::make_shared<OutsideFuture<FindResult>>();
+	{
+		std::unique_lock lok(lock);
+		auto now = Clock::now();
+		auto it = entries.find(key);
+		if(it != entries.end()){
+			if(it->second.running){
+				joined++;
+				it->second.waiting.push_back({engine, f});
+				return f;
+			}
+			if(it->second.expires > now){
+				hits++;
+				return completed(it->second.answer());
+			}
+			entries.erase(it);
+		}
+		misses++;
+		prune(now);
+		entries[key].waiting.push_back({engine, f});
+		running++;
+	}
+	if(!pool.post([this, key](){ resolve(key); })) resolve(key);
+	return f;
+}
+
+void Resolver::resolve(const Key& key){
+	::addrinfo hints = {};
+	hints.ai_flags = key.flags;
+	hints.ai_family = key.family;
+	hints.ai_socktype = key.socktype;
+	hints.ai_protocol = key.protocol;
+	auto found = NetworkedAddressInfo::find(key.address, key.port, hints);
+	Entry done;
+	done.running = false;
+	if(auto err = found.err()) done.error = *err;
+	else done.found = std::make_shared<const NetworkedAddressInfo>(std::move(*found.ok()));
+	std::vector<Waiter> waiting;
+	{
+		std::unique_lock lok(lock);
+		running--;
+		auto it = entries.find(key);
+		if(it != entries.end()){ //always, unless cleared meanwhile
+			waiting = std::move(it->second.waiting);
+			auto ttl = done.error ? config.negativeTtl : config.ttl;
+			if(ttl > Clock::duration::zero()){
+				done.expires = Clock::now() + ttl;
+				it->second = done;
+			} else entries.erase(it);
+		}
+	}
+	for(auto& w : waiting){
+		w.future->completed(done.answer());
+		w.engine->notify(w.future);
+	}
+}
+
+void Resolver::clear(){
+	std::unique_lock lok(lock);
+	for(auto it = entries.begin(); it != entries.end();){
+		if(!it->second.running) it = entries.erase(it);
+		else ++it;
+	}
+}
+
+ResolverStats Resolver::stats(){
+	std::unique_lock lok(lock);
+	return ResolverStats{hits, misses, joined, entries.size() - running, running};
+}
+
+Resolver& Resolver::shared(){
+	static Resolver resolver;
+	return resolver;
+}
+
+Future<NetworkedAddressInfo::FindResult> NetworkedAddressInfo::findAsync(Yengine* engine, const std::string& address, const std::string& port, const ::addrinfo& hints){
+	return Resolver::shared().find(engine, address, port, hints);
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "iosock.hpp"
+
+#include <map>
+
+namespace yasync::io {
+
+struct ResolverConfig {
+	using Duration = std::chrono::steady_clock::duration;
+	/// How long found addresses are reused, the system resolver does not tell record TTLs. `0` to not cache
+	Duration ttl = std::chrono::seconds(30);
+	/// How long failures are reused, `0` to retry every time
+	Duration negativeTtl = Duration::zero();
+	/// Cached lookups kept at most, the soonest to expire go first
+	size_t capacity = 1024;
+	/// Threads running `getaddrinfo`, apart from the engine's own blocking pool so that slow lookups never starve it
+	BlockingPoolConfig pool = BlockingPoolConfig{4, 0};
+};
+
+struct ResolverStats {
+	/// Lookups answered from the cache, started, and joined onto one already running
+	unsigned long long hits, misses, joined;
+	/// Cached lookups, and lookups running
+	size_t cached, running;
+};
+
+/**
+ * Asynchronous `getaddrinfo`.
+ * Lookups run on the resolver's own threads and complete into the asking engine.
+ * Concurrent identical lookups (same address, port and hints) share one call, and results are cached for a while.
+ */
+class Resolver {
+	public:
+		using Clock = std::chrono::steady_clock;
+		using FindResult = NetworkedAddressInfo::FindResult;
+	private:
+		struct Key {
+			std::string address, port;
+			int flags, family, socktype, protocol;
+			bool operator<(const Key& other) const;
+		};
+		struct Waiter {
+			Yengine* engine;
+			std::shared_ptr<OutsideFuture<FindResult>> future;
+		};
+		struct Entry {
+			bool running = true;
+			std::shared_ptr<const NetworkedAddressInfo> found;
+			std::optional<SysError> error;
+			Clock::time_point expires;
+			std::vector<Waiter> waiting;
+			inline FindResult answer() const { return error ? FindResult::Err(*error) : FindResult::Ok(found->clone()); }
+		};
+		ResolverConfig config;
+		std::mutex lock;
+		std::map<Key, Entry> entries;
+		unsigned long long hits = 0, misses = 0, joined = 0;
+		size_t running = 0;
+		/// Last, so that lookups still running are done before the rest goes
+		BlockingPool pool;
+		void resolve(const Key& key);
+		/// Makes room for one more, under lock
+		void prune(Clock::time_point now);
+	public:
+		Resolver(const ResolverConfig& config = ResolverConfig());
+		Resolver(const Resolver&) = delete;
+		Resolver& operator=(const Resolver&) = delete;
+		/**
+		 * @param engine engine to complete into
+		 * @returns own copy of the addresses
+		 */
+		Future<FindResult> find(Yengine* engine, const std::string& address, const std::string& port, const ::addrinfo& hints);
+		template<int SDomain, int SType, int SProto> Future<FindResult> find(Yengine* engine, const std::string& address, const std::string& port){ return find(engine, address, port, NetworkedAddressInfo::hint<SDomain, SType, SProto>()); }
+		/**
+		 * Drops cached lookups, running ones are left be
+		 */
+		void clear();
+		ResolverStats stats();
+		/**
+		 * Process-wide resolver, with the default configuration, behind @ref NetworkedAddressInfo::findAsync
+		 */
+		static Resolver& shared();
+};
+
+}
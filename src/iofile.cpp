@@ -0,0 +1,133 @@
+#include "iofile.hpp"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <memoryapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace yasync::io {
+
+constexpr size_t MAPPED_READ_UNIT = 1 << 16;
+
+FileMapping::MapResult FileMapping::map(const std::string& path){
+	std::shared_ptr<FileMapping> m(new FileMapping());
+	#ifdef _WIN32
+	HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE) return retSysError<MapResult>("Open file failed");
+	LARGE_INTEGER size;
+	if(!::GetFileSizeEx(file, &size)){
+		auto err = ::GetLastError();
+		::CloseHandle(file);
+		return retSysError<MapResult>("Get file size failed", err);
+	}
+	m->length = static_cast<size_t>(size.QuadPart);
+	if(m->length > 0){
+		m->mapping = ::CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		auto err = ::GetLastError();
+		::CloseHandle(file);
+		if(!m->mapping) return retSysError<MapResult>("Create file mapping failed", err);
+		m->base = static_cast<const char*>(::MapViewOfFile(m->mapping, FILE_MAP_READ, 0, 0, 0));
+		if(!m->base) return retSysError<MapResult>("Map view of file failed");
+	} else ::CloseHandle(file);
+	#else
+	int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(file < 0) return retSysError<MapResult>("Open file failed");
+	struct ::stat st;
+	if(::fstat(file, &st) < 0){
+		auto err = errno;
+		::close(file);
+		return retSysError<MapResult>("Get file size failed", err);
+	}
+	m->length = st.st_size;
+	if(m->length > 0){ //an empty file can not be mapped, but it doesn't need to be either
+		auto base = ::mmap(nullptr, m->length, PROT_READ, MAP_PRIVATE, file, 0);
+		auto err = errno;
+		::close(file); //the mapping holds on to the file
+		if(base == MAP_FAILED) return retSysError<MapResult>("Map file failed", err);
+		m->base = static_cast<const char*>(base);
+	} else ::close(file);
+	#endif
+	return MapResult::Ok(std::move(m));
+}
+
+FileMapping::~FileMapping(){
+	#ifdef _WIN32
+	if(base) ::UnmapViewOfFile(base);
+	if(mapping) ::CloseHandle(mapping);
+	#else
+	if(base) ::munmap(const_cast<char*>(base), length);
+	#endif
+}
+
+FileMapping::AdviseResult FileMapping::advise(MapAdvice advice, uint64_t offset, size_t len) const {
+	if(offset >= length) return AdviseResult::Ok();
+	if(len == 0 || len > length - offset) len = length - offset;
+	#ifdef _WIN32
+	if(advice != MapAdvice::WillNeed) return AdviseResult::Ok(); //nothing to tell
+	WIN32_MEMORY_RANGE_ENTRY range = {const_cast<char*>(base + offset), len};
+	if(!::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0)) return retSysError<AdviseResult>("Prefetch mapping failed");
+	#else
+	int adv;
+	switch(advice){
+		case MapAdvice::Sequential: adv = MADV_SEQUENTIAL; break;
+		case MapAdvice::Random: adv = MADV_RANDOM; break;
+		case MapAdvice::WillNeed: adv = MADV_WILLNEED; break;
+		case MapAdvice::DontNeed: adv = MADV_DONTNEED; break;
+		default: adv = MADV_NORMAL;
+	}
+	//advice goes by whole pages
+	static const uint64_t page = ::sysconf(_SC_PAGESIZE);
+	auto start = offset & ~(page-1);
+	if(::madvise(const_cast<char*>(base + start), len + (offset - start), adv) < 0) return retSysError<AdviseResult>("Advise mapping failed");
+	#endif
+	return AdviseResult::Ok();
+}
+
+std::shared_ptr<MappedFileResource> MappedFileResource::make(Yengine* e, std::shared_ptr<const FileMapping> m){
+	std::shared_ptr<MappedFileResource> r(new MappedFileResource(e, std::move(m)));
+	r->setSelf(r);
+	return r;
+}
+
+Future<IAIOResource::ReadResult> MappedFileResource::_read(size_t bytes){
+	//a single byte read is one read unit, as for any resource
+	auto sv = next(bytes > 0 ? std::max(bytes, MAPPED_READ_UNIT) : 0);
+	return completed(ReadResult::Ok(std::vector<char>(sv.data.begin(), sv.data.end())));
+}
+Future<IAIOResource::WriteResult> MappedFileResource::_write(std::vector<char>&&){
+	return completed(WriteResult::Err("Mapped file is read only"));
+}
+Future<IAIOResource::ReadResult> MappedFileResource::_readAt(uint64_t offset, size_t bytes){
+	auto sv = slice(offset, bytes);
+	return completed(ReadResult::Ok(std::vector<char>(sv.data.begin(), sv.data.end())));
+}
+Future<IAIOResource::WriteResult> MappedFileResource::_writeAt(uint64_t, OutboundQueue&&){
+	return completed(WriteResult::Err("Mapped file is read only"));
+}
+
+SharedView MappedFileResource::slice(uint64_t offset, size_t length) const {
+	auto v = view();
+	if(offset >= v.size()) return SharedView{mapping, std::string_view()};
+	return SharedView{mapping, v.substr(offset, length)};
+}
+SharedView MappedFileResource::next(size_t bytes){
+	auto sv = slice(pos, bytes > 0 ? bytes : std::string_view::npos);
+	pos += sv.data.size();
+	return sv;
+}
+
+FileMapResult fileMapRead(IOYengine* engine, const std::string& path, MapAdvice advice){
+	auto mr = FileMapping::map(path);
+	if(auto err = mr.err()) return FileMapResult::Err(*err);
+	auto m = *mr.ok();
+	m->advise(advice); //only a hint, failing it changes nothing
+	return FileMapResult::Ok(MappedFileResource::make(engine->engine, std::move(m)));
+}
+
+}
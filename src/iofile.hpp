@@ -0,0 +1,192 @@
+#pragma once
+
+#include "io.hpp"
+
+#include <cstdint>
+
+namespace yasync::io {
+
+enum class MapAdvice {
+	Normal, Sequential, Random, WillNeed, DontNeed
+};
+
+/**
+ * Read-only mapping of a whole file.
+ */
+class FileMapping {
+	const char* base = nullptr;
+	size_t length = 0;
+	#ifdef _WIN32
+	HANDLE mapping = NULL;
+	#endif
+	FileMapping() = default;
+	public:
+		using MapResult = result<std::shared_ptr<const FileMapping>, SysError>;
+		static MapResult map(const std::string& path);
+		FileMapping(const FileMapping&) = delete;
+		FileMapping& operator=(const FileMapping&) = delete;
+		~FileMapping();
+		inline std::string_view view() const { return std::string_view(base, length); }
+		inline size_t size() const { return length; }
+		using AdviseResult = result<void, SysError>;
+		/**
+		 * Hints the expected access to (a part of) the mapping
+		 * @param length `0` till the end
+		 */
+		AdviseResult advise(MapAdvice advice, uint64_t offset = 0, size_t length = 0) const;
+};
+
+/**
+ * Memory mapped file.
+ * Reads copy straight out of the mapping without any IO, slices hand out the mapped memory itself.
+ * Writes are not supported.
+ */
+class MappedFileResource : public IAIOResource {
+	std::shared_ptr<const FileMapping> mapping;
+	size_t pos = 0;
+	MappedFileResource(Yengine* e, std::shared_ptr<const FileMapping> m) : IAIOResource(e), mapping(std::move(m)) {}
+	void notify(IOCompletionInfo) override {}
+	public:
+		static std::shared_ptr<MappedFileResource> make(Yengine* e, std::shared_ptr<const FileMapping> m);
+		void cancel() override {}
+		Future<ReadResult> _read(size_t bytes = 0) override;
+		Future<WriteResult> _write(std::vector<char>&& data) override;
+		Future<ReadResult> _readAt(uint64_t offset, size_t bytes) override;
+		Future<WriteResult> _writeAt(uint64_t offset, OutboundQueue&& data) override;
+		inline std::string_view view() const { return mapping->view(); }
+		inline size_t size() const { return mapping->size(); }
+		/**
+		 * Slice of the mapping, clamped to its end.
+		 * The slice keeps the mapping alive, and writes out without copying.
+		 */
+		SharedView slice(uint64_t offset, size_t length) const;
+		/**
+		 * Takes the next slice of the stream, empty at EOD.
+		 * Data buffered by read or peek is not included.
+		 * @param bytes `0` till the end
+		 */
+		SharedView next(size_t bytes = 0);
+		inline FileMapping::AdviseResult advise(MapAdvice advice, uint64_t offset = 0, size_t length = 0) const { return mapping->advise(advice, offset, length); }
+};
+using MappedFile = std::shared_ptr<MappedFileResource>;
+
+using FileMapResult = result<MappedFile, SysError>;
+/**
+ * Maps the file for reading
+ * @param advice expected access
+ */
+FileMapResult fileMapRead(IOYengine*, const std::string& path, MapAdvice advice = MapAdvice::Sequential);
+
+using RangeResult = result<void, SysError>;
+
+constexpr size_t DEFAULT_RANGE_CHUNK = 1 << 20;
+
+/**
+ * Reads a range of a resource, chunk after chunk, with positional reads.
+ * Every chunk is handed over to `f(range, offset, data)` before the next one is read.
+ * If `f` returns a future, it is awaited before reading on.
+ */
+template<typename F> class RangeGenerator : public IGeneratorT<RangeResult> {
+	IOResource resource;
+	std::shared_ptr<F> f;
+	unsigned range;
+	uint64_t pos, end;
+	size_t chunk;
+	bool d = false;
+	std::optional<Future<IAIOResource::ReadResult>> rd = std::nullopt;
+	std::optional<Future<RangeResult>> step = std::nullopt;
+	inline RangeResult finish(RangeResult && r){
+		d = true;
+		return std::move(r);
+	}
+	public:
+		RangeGenerator(IOResource r, std::shared_ptr<F> fp, unsigned rng, uint64_t from, uint64_t to, size_t ch) : resource(r), f(fp), range(rng), pos(from), end(to), chunk(ch) {}
+		bool done() const override { return d; }
+		Generesume<RangeResult> resume(const Yengine*) override {
+			if(rd){
+				auto res = rd->result();
+				rd = std::nullopt;
+				if(auto err = res.err()) return finish(RangeResult::Err(*err));
+				auto& data = *res.ok();
+				auto at = pos;
+				auto requested = std::min<uint64_t>(chunk, end-pos);
+				if(data.size() < requested) end = pos + data.size(); //EOF, the range ends early
+				pos += data.size();
+				if(!data.empty()){
+					if constexpr (std::is_void<std::invoke_result_t<F&, unsigned, uint64_t, std::vector<char>&&>>::value) (*f)(range, at, std::move(data));
+					else return *(step = (*f)(range, at, std::move(data)));
+				}
+			}
+			if(step){
+				auto res = step->result();
+				step = std::nullopt;
+				if(auto err = res.err()) return finish(RangeResult::Err(*err));
+			}
+			if(pos >= end) return finish(RangeResult::Ok());
+			return *(rd = resource->readAt<std::vector<char>>(pos, std::min<uint64_t>(chunk, end-pos)));
+		}
+};
+
+/**
+ * Splits `[offset, offset+length)` into equal contiguous ranges processed concurrently on the engine.
+ * Each range is read in order, chunk by chunk, with each chunk handed over to `f(range, offset, data)` - `void`, or `Future<RangeResult>` to be awaited before reading on.
+ * `f` is shared among the ranges, and may be invoked from several threads at once (for different ranges).
+ * A range ends early at EOF.
+ * @param resource positional resource to read from
+ * @param offset start of the data
+ * @param length length of the data
+ * @param ranges number of concurrent ranges
+ * @param f chunk consumer
+ * @param chunk read size
+ * @returns completes once all ranges are done, with the first error if any
+ */
+template<typename F> Future<RangeResult> forRanges(IOResource resource, uint64_t offset, uint64_t length, unsigned ranges, F && f, size_t chunk = DEFAULT_RANGE_CHUNK){
+	struct Join {
+		std::mutex lock;
+		unsigned left;
+		RangeResult first = RangeResult::Ok();
+		std::shared_ptr<OutsideFuture<RangeResult>> n = std::make_shared<OutsideFuture<RangeResult>>();
+	};
+	ranges = std::max(1u, static_cast<unsigned>(std::min<uint64_t>(ranges, std::max<uint64_t>(1, length / std::max<size_t>(1, chunk)))));
+	auto join = std::make_shared<Join>();
+	join->left = ranges;
+	auto fp = std::make_shared<std::decay_t<F>>(std::forward<F>(f));
+	auto engine = resource->engine;
+	uint64_t per = length / ranges;
+	for(unsigned i = 0; i < ranges; i++){
+		uint64_t from = offset + per*i;
+		uint64_t to = i+1 == ranges ? offset + length : from + per;
+		engine <<= defer(Generator<RangeResult>(new RangeGenerator<std::decay_t<F>>(resource, fp, i, from, to, chunk))) >> [join, engine](RangeResult r){
+			std::unique_lock lok(join->lock);
+			if(r.isErr() && join->first.isOk()) join->first = std::move(r);
+			if(--join->left == 0){
+				join->n->completed(std::move(join->first));
+				engine->notify(join->n);
+			}
+		};
+	}
+	return join->n;
+}
+
+/**
+ * Sends a part of the file to the resource (socket), without passing it through user space where possible.
+ * Progress is driven by the resource becoming writable, resources or files that can't do that get the file copied over in chunks.
+ * @param to resource to send to
+ * @param file file to send from
+ * @param offset position in the file
+ * @param length number of bytes to send, `0` till EOF
+ * @returns number of bytes sent
+ */
+inline Future<IAIOResource::SendResult> sendFile(const IOResource& to, const IOResource& file, uint64_t offset = 0, uint64_t length = 0){
+	return to->sendFile(file, offset, length);
+}
+
+/**
+ * Copies `[offset, offset+length)` from one resource to the same position of another, in concurrent ranges.
+ * @see forRanges
+ */
+inline Future<RangeResult> parallelCopy(IOResource from, IOResource to, uint64_t offset, uint64_t length, unsigned ranges, size_t chunk = DEFAULT_RANGE_CHUNK){
+	return forRanges(from, offset, length, ranges, [to](unsigned, uint64_t at, std::vector<char>&& data){ return to->writeAt(at, std::move(data)); }, chunk);
+}
+
+}
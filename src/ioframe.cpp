@@ -0,0 +1,85 @@
+#include "ioframe.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace yasync::io {
+
+DelimiterFramer::DelimiterFramer(const std::string& delimiter, size_t ml) : delim(delimiter.begin(), delimiter.end()), maxLength(ml) {
+	if(delim.empty()) throw std::invalid_argument("Delimiter must not be empty");
+}
+
+DelimiterFramer::DecodeResult DelimiterFramer::decode(const char* data, size_t size, Frame& frame){
+	const size_t dl = delim.size();
+	//memchr for the first byte of the delimiter is vectorized by libc, only the candidates get compared in full
+	for(size_t from = scanned; from + dl <= size;){
+		auto cand = static_cast<const char*>(std::memchr(data+from, delim[0], size-from-dl+1));
+		if(!cand) break;
+		size_t at = cand-data;
+		if(std::memcmp(cand+1, delim.data()+1, dl-1) == 0){
+			scanned = 0;
+			if(at > maxLength) return DecodeResult::Err("Frame exceeds maximum length");
+			frame.assign(data, data+at);
+			return DecodeResult::Ok(at+dl);
+		}
+		from = at+1;
+	}
+	//Everything that can not be the start of the delimiter has been scanned, don't scan it again
+	scanned = size >= dl ? size-dl+1 : 0;
+	if(scanned > maxLength) return DecodeResult::Err("Frame exceeds maximum length");
+	return DecodeResult::Ok(0);
+}
+
+bool DelimiterFramer::encode(const char* data, size_t size, std::vector<char>& out) const {
+	if(size > maxLength) return false;
+	auto start = out.size();
+	out.reserve(start + size + delim.size());
+	out.insert(out.end(), data, data+size);
+	out.insert(out.end(), delim.begin(), delim.end());
+	//the delimiter within the data, or straddling its end, would cut the frame short on the other side
+	if(static_cast<size_t>(std::search(out.begin()+start, out.end(), delim.begin(), delim.end()) - out.begin()) != start+size){
+		out.resize(start);
+		return false;
+	}
+	return true;
+}
+
+LineFramer::LineFramer(size_t ml) : lf("\n", ml+1), maxLength(ml) {}
+
+LineFramer::DecodeResult LineFramer::decode(const char* data, size_t size, Frame& frame){
+	auto r = lf.decode(data, size, frame);
+	if(r.isOk() && *r.ok() > 0){
+		if(!frame.empty() && frame.back() == '\r') frame.pop_back();
+		if(frame.size() > maxLength) return DecodeResult::Err("Frame exceeds maximum length");
+	}
+	return r;
+}
+
+bool LineFramer::encode(const char* data, size_t size, std::vector<char>& out) const {
+	//a trailing carriage return would be taken for a part of the terminator
+	if(size > maxLength || (size > 0 && data[size-1] == '\r')) return false;
+	return lf.encode(data, size, out);
+}
+
+VarIntDecodeResult decodeVarInt(const char* data, size_t size){
+	uint64_t v = 0;
+	for(size_t i = 0; i < size; i++){
+		if(i >= 10) return VarIntDecodeResult::Err("VarInt overflow");
+		auto b = static_cast<unsigned char>(data[i]);
+		if(i == 9 && b > 1) return VarIntDecodeResult::Err("VarInt overflow");
+		v |= uint64_t(b & 0x7F) << (7*i);
+		if(!(b & 0x80)) return VarIntDecodeResult::Ok(std::make_pair(v, i+1));
+	}
+	if(size >= 10) return VarIntDecodeResult::Err("VarInt overflow");
+	return VarIntDecodeResult::Ok(std::nullopt);
+}
+
+void encodeVarInt(uint64_t v, std::vector<char>& out){
+	while(v >= 0x80){
+		out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<char>(v));
+}
+
+}
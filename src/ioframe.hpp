@@ -0,0 +1,214 @@
+#pragma once
+
+#include "io.hpp"
+
+#include <cstdint>
+
+namespace yasync::io {
+
+using Frame = std::vector<char>;
+using FrameResult = result<Frame, SysError>;
+
+constexpr size_t DEFAULT_MAX_FRAME_LENGTH = 1 << 20;
+
+/*
+ * Framers
+ * A framer cuts frames out of a contiguous chunk of data, and composes data into a frame.
+ * - `DecodeResult decode(const char* data, size_t size, Frame& frame)` returns the number of bytes consumed by the frame stored in `frame`, or `0` if more data is needed
+ * - `bool encode(const char* data, size_t size, std::vector<char>& out) const` appends the framed data to `out`, or returns false if the data can not be framed (leaving `out` as is)
+ * Decoding is always invoked on the unconsumed data starting at the same position until a frame is produced, so framers may keep scan state in between.
+ */
+
+using FrameDecodeResult = result<size_t, SysError>;
+
+/**
+ * Frames separated by a delimiter sequence. The delimiter is not included in the frame, and can not be a part of it.
+ */
+class DelimiterFramer {
+	std::vector<char> delim;
+	size_t maxLength;
+	size_t scanned = 0;
+	public:
+		using DecodeResult = FrameDecodeResult;
+		DelimiterFramer(const std::string& delimiter, size_t maxLength = DEFAULT_MAX_FRAME_LENGTH);
+		DecodeResult decode(const char* data, size_t size, Frame& frame);
+		bool encode(const char* data, size_t size, std::vector<char>& out) const;
+};
+
+/**
+ * Lines, terminated by `\n` or `\r\n`. The terminator is not included in the frame (nor counted towards its length).
+ */
+class LineFramer {
+	DelimiterFramer lf;
+	size_t maxLength;
+	public:
+		using DecodeResult = FrameDecodeResult;
+		LineFramer(size_t maxLength = DEFAULT_MAX_FRAME_LENGTH);
+		DecodeResult decode(const char* data, size_t size, Frame& frame);
+		bool encode(const char* data, size_t size, std::vector<char>& out) const;
+};
+
+enum class LengthPrefix {
+	U16BE, U16LE, U32BE, U32LE, VarInt
+};
+
+using VarIntDecodeResult = result<std::optional<std::pair<uint64_t, size_t>>, SysError>;
+/**
+ * Decodes unsigned LEB128 varint
+ * @returns value and number of bytes it occupies, nothing if incomplete
+ */
+VarIntDecodeResult decodeVarInt(const char* data, size_t size);
+void encodeVarInt(uint64_t v, std::vector<char>& out);
+
+/**
+ * Frames prefixed by their length. The prefix is not included in the frame.
+ */
+template<LengthPrefix P> class LengthPrefixedFramer {
+	size_t maxLength;
+	template<unsigned N, bool BE> static inline uint64_t decodeFixed(const char* data){
+		uint64_t v = 0;
+		for(unsigned i = 0; i < N; i++) v |= uint64_t(static_cast<unsigned char>(data[BE ? i : N-1-i])) << (8*(N-1-i));
+		return v;
+	}
+	template<unsigned N, bool BE> static inline void encodeFixed(uint64_t v, std::vector<char>& out){
+		for(unsigned i = 0; i < N; i++) out.push_back(static_cast<char>(v >> (8*(BE ? N-1-i : i))));
+	}
+	public:
+		using DecodeResult = FrameDecodeResult;
+		static constexpr size_t maxPrefixed = P == LengthPrefix::U16BE || P == LengthPrefix::U16LE ? 0xFFFF : P == LengthPrefix::VarInt ? SIZE_MAX : 0xFFFFFFFF;
+		LengthPrefixedFramer(size_t maxLen = DEFAULT_MAX_FRAME_LENGTH) : maxLength(std::min(maxLen, maxPrefixed)) {}
+		DecodeResult decode(const char* data, size_t size, Frame& frame){
+			uint64_t len;
+			size_t pl;
+			if constexpr (P == LengthPrefix::VarInt){
+				auto vr = decodeVarInt(data, size);
+				if(auto err = vr.err()) return DecodeResult::Err(*err);
+				if(!*vr.ok()) return DecodeResult::Ok(0);
+				std::tie(len, pl) = **vr.ok();
+			} else {
+				pl = P == LengthPrefix::U16BE || P == LengthPrefix::U16LE ? 2 : 4;
+				if(size < pl) return DecodeResult::Ok(0);
+				switch(P){
+					case LengthPrefix::U16BE: len = decodeFixed<2, true>(data); break;
+					case LengthPrefix::U16LE: len = decodeFixed<2, false>(data); break;
+					case LengthPrefix::U32BE: len = decodeFixed<4, true>(data); break;
+					case LengthPrefix::U32LE: len = decodeFixed<4, false>(data); break;
+					default: return DecodeResult::Err("Unknown length prefix");
+				}
+			}
+			if(len > maxLength) return DecodeResult::Err("Frame exceeds maximum length");
+			if(size - pl < len) return DecodeResult::Ok(0);
+			frame.assign(data + pl, data + pl + len);
+			return DecodeResult::Ok(pl + len);
+		}
+		/**
+		 * @returns false if the frame is longer than the maximum, a truncated prefix would desync the peer
+		 */
+		bool encode(const char* data, size_t size, std::vector<char>& out) const {
+			if(size > maxLength) return false;
+			out.reserve(out.size() + size + 10);
+			switch(P){
+				case LengthPrefix::U16BE: encodeFixed<2, true>(size, out); break;
+				case LengthPrefix::U16LE: encodeFixed<2, false>(size, out); break;
+				case LengthPrefix::U32BE: encodeFixed<4, true>(size, out); break;
+				case LengthPrefix::U32LE: encodeFixed<4, false>(size, out); break;
+				case LengthPrefix::VarInt: encodeVarInt(size, out); break;
+			}
+			out.insert(out.end(), data, data + size);
+			return true;
+		}
+};
+
+/**
+ * IOResource → Frame?..
+ * Reads whatever is available from the resource, and yields as many frames as there are in it before reading again.
+ * Frames are yielded as they come, errors are yielded once and end the stream.
+ */
+template<typename Framer> class FramingGenerator : public IGeneratorT<Maybe<FrameResult>> {
+	IOResource resource;
+	Framer framer;
+	std::vector<char> buff;
+	size_t off = 0;
+	bool eod = false;
+	bool d = false;
+	std::optional<Future<IAIOResource::ReadResult>> rd = std::nullopt;
+	void compact(){
+		if(off == buff.size()){
+			buff.clear();
+			off = 0;
+		} else if(off >= buff.size()/2){ //amortized, we move each byte at most once more
+			buff.erase(buff.begin(), buff.begin()+off);
+			off = 0;
+		}
+	}
+	public:
+		FramingGenerator(IOResource r, Framer && f) : resource(r), framer(std::move(f)) {}
+		bool done() const override { return d; }
+		Generesume<Maybe<FrameResult>> resume(const Yengine*) override {
+			if(rd){
+				auto res = rd->result();
+				rd = std::nullopt;
+				if(auto err = res.err()){
+					d = true;
+					return Maybe<FrameResult>(FrameResult::Err(*err));
+				}
+				auto& data = *res.ok();
+				if(data.empty()) eod = true;
+				else if(off == buff.size()){
+					buff = std::move(data);
+					off = 0;
+				} else buff.insert(buff.end(), data.begin(), data.end());
+			}
+			Frame frame;
+			auto dr = framer.decode(buff.data()+off, buff.size()-off, frame);
+			if(auto err = dr.err()){
+				d = true;
+				return Maybe<FrameResult>(FrameResult::Err(*err));
+			}
+			if(auto consumed = *dr.ok()){
+				off += consumed;
+				compact();
+				return Maybe<FrameResult>(FrameResult::Ok(std::move(frame)));
+			}
+			if(eod){
+				d = true;
+				if(off < buff.size()) return Maybe<FrameResult>(FrameResult::Err("Reached EOF mid-frame"));
+				return Maybe<FrameResult>();
+			}
+			return *(rd = resource->readSome<std::vector<char>>());
+		}
+};
+
+/**
+ * Transforms the resource into a stream of frames.
+ * The stream takes over reading from the resource.
+ * @param resource resource to read from
+ * @param framer framer cutting the frames
+ * @returns stream of frames, ends on EOD
+ */
+template<typename Framer> Future<Maybe<FrameResult>> frames(IOResource resource, Framer && framer){
+	return defer(Generator<Maybe<FrameResult>>(new FramingGenerator<Framer>(resource, std::move(framer))));
+}
+inline Future<Maybe<FrameResult>> lineFrames(IOResource resource, size_t maxLength = DEFAULT_MAX_FRAME_LENGTH){
+	return frames(resource, LineFramer(maxLength));
+}
+inline Future<Maybe<FrameResult>> delimitedFrames(IOResource resource, const std::string& delimiter, size_t maxLength = DEFAULT_MAX_FRAME_LENGTH){
+	return frames(resource, DelimiterFramer(delimiter, maxLength));
+}
+template<LengthPrefix P> Future<Maybe<FrameResult>> lengthPrefixedFrames(IOResource resource, size_t maxLength = DEFAULT_MAX_FRAME_LENGTH){
+	return frames(resource, LengthPrefixedFramer<P>(maxLength));
+}
+
+/**
+ * Frames and writes the data, or errors if the framer can't frame it
+ */
+template<typename Framer> Future<IAIOResource::WriteResult> writeFrame(const IOResource& resource, const Framer& framer, const char* data, size_t size){
+	std::vector<char> out;
+	if(!framer.encode(data, size, out)) return completed(IAIOResource::WriteResult::Err("Data can not be framed (exceeds maximum length, or contains the delimiter)"));
+	return resource->write(std::move(out));
+}
+template<typename Framer, typename Range> Future<IAIOResource::WriteResult> writeFrame(const IOResource& resource, const Framer& framer, const Range& data){
+	return writeFrame(resource, framer, data.data(), data.size());
+}
+
+}
@@ -0,0 +1,267 @@
+#include "ioipc.hpp"
+
+#ifndef _WIN32
+
+#include "spscring.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <cstdio>
+#include <new>
+
+namespace yasync::io {
+
+constexpr uint64_t IPC_MAGIC = 0x7961737969706331; //yasyipc1
+constexpr size_t IPC_PAGE = 4096;
+
+/**
+ * Shared state of one direction
+ */
+struct IpcDirection {
+	SpscRingIndices ring;
+	alignas(CACHE_LINE) std::atomic<uint32_t> readerParked = 0, writerParked = 0;
+	std::atomic<uint32_t> readerGone = 0, writerGone = 0;
+	static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared flags must be lock-free");
+};
+/**
+ * Head of the shared memory, followed by the data of direction 0, then of direction 1, each on page boundary
+ */
+struct IpcLayout {
+	uint64_t magic;
+	uint64_t capacity;
+	IpcDirection dir[2];
+};
+constexpr size_t IPC_DATA_OFFSET = (sizeof(IpcLayout) + IPC_PAGE - 1) / IPC_PAGE * IPC_PAGE;
+
+class IpcDescriptor : public IHandledResource {
+	public:
+		IpcDescriptor(fd_t f) : IHandledResource(f) {}
+		~IpcDescriptor(){ ::close(rh); }
+};
+
+IpcChannel& IpcChannel::inheritable(bool inherit){
+	auto set = [inherit](fd_t f){
+		if(f >= 0) ::fcntl(f, F_SETFD, inherit ? 0 : FD_CLOEXEC);
+	};
+	set(memory);
+	for(auto b : bells) set(b);
+	for(auto a : alive) set(a);
+	return *this;
+}
+std::string IpcChannel::str() const {
+	return std::to_string(memory) + ',' + std::to_string(bells[0]) + ',' + std::to_string(bells[1]) + ',' + std::to_string(bells[2]) + ',' + std::to_string(bells[3]) + ',' + std::to_string(alive[0]) + ',' + std::to_string(alive[1]);
+}
+std::optional<IpcChannel> IpcChannel::parse(const std::string& s){
+	IpcChannel ch;
+	int consumed = 0;
+	if(std::sscanf(s.c_str(), "%d,%d,%d,%d,%d,%d,%d%n", &ch.memory, &ch.bells[0], &ch.bells[1], &ch.bells[2], &ch.bells[3], &ch.alive[0], &ch.alive[1], &consumed) != 7 || size_t(consumed) != s.size()) return std::nullopt;
+	return ch;
+}
+void IpcChannel::close(){
+	if(memory >= 0) ::close(memory);
+	memory = -1;
+	for(auto& b : bells){
+		if(b >= 0) ::close(b);
+		b = -1;
+	}
+	for(auto& a : alive){
+		if(a >= 0) ::close(a);
+		a = -1;
+	}
+}
+
+IpcCreateResult ipcCreate(size_t capacity){
+	IpcChannel ch;
+	auto fail = [&ch](const char* msg){
+		auto err = SysError::last(msg);
+		ch.close();
+		return IpcCreateResult::Err(err);
+	};
+	auto cap = ringCapacity(std::max(capacity, IPC_PAGE));
+	ch.memory = ::memfd_create("yasync-ipc", MFD_CLOEXEC);
+	if(ch.memory < 0) return fail("Shared memory creation failed");
+	auto size = IPC_DATA_OFFSET + 2*cap;
+	if(::ftruncate(ch.memory, size)) return fail("Shared memory sizing failed");
+	auto mem = ::mmap(nullptr, IPC_DATA_OFFSET, PROT_READ | PROT_WRITE, MAP_SHARED, ch.memory, 0);
+	if(mem == MAP_FAILED) return fail("Shared memory mapping failed");
+	new(mem) IpcLayout{IPC_MAGIC, cap, {}};
+	::munmap(mem, IPC_DATA_OFFSET);
+	for(auto& b : ch.bells) if((b = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0) return fail("Doorbell creation failed");
+	if(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, ch.alive.data())) return fail("Liveness socket creation failed");
+	return IpcCreateResult::Ok(ch);
+}
+
+/**
+ * One end of a channel.
+ * Each side parks by raising its flag, and rechecks the ring before waiting on its doorbell. The other side rings the bell only if it sees the flag raised after making progress.
+ */
+class IpcResource : public IAIOResource {
+	IpcLayout* layout;
+	size_t mapped;
+	size_t cap;
+	IpcDirection& in;
+	IpcDirection& out;
+	const char* inData;
+	char* outData;
+	/// Awaited: data available on the way in, room available on the way out
+	IOResource dataBell, roomBell;
+	/// Rung: data available on the way out, room available on the way in
+	fd_t dataRing, roomRing;
+	/// Hangs up once the peer is gone, read from only to tell that
+	IOResource alive;
+	IpcResource(Yengine* e, IpcLayout* l, size_t m, unsigned end, IOResource db, IOResource rb, fd_t dr, fd_t rr) : IAIOResource(e), layout(l), mapped(m), cap(l->capacity), in(l->dir[1-end]), out(l->dir[end]), dataBell(db), roomBell(rb), dataRing(dr), roomRing(rr) {
+		auto data = reinterpret_cast<char*>(l) + IPC_DATA_OFFSET;
+		inData = data + (1-end)*cap;
+		outData = data + end*cap;
+	}
+	static inline void wake(std::atomic<uint32_t>& parked, fd_t bell){
+		//pairs with the fence in park, either the parked side sees our progress, or we see it parked
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(parked.load(std::memory_order_relaxed) && parked.exchange(0)) ::eventfd_write(bell, 1);
+	}
+	/**
+	 * @returns whether the side has to wait for its bell
+	 */
+	template<typename Ready> static inline bool park(std::atomic<uint32_t>& parked, Ready ready){
+		parked.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(!ready()) return true;
+		parked.store(0, std::memory_order_relaxed); //a bell rung meanwhile merely wakes the next wait early
+		return false;
+	}
+	void notify(IOCompletionInfo) override {}
+	/// Closes the peer's side on its behalf - it died without doing so - and wakes this side up to see it
+	void peerGone(){
+		in.writerGone.store(1, std::memory_order_release);
+		out.readerGone.store(1, std::memory_order_release);
+		in.readerParked.store(0, std::memory_order_relaxed);
+		::eventfd_write(*dataBell->handle(), 1);
+		out.writerParked.store(0, std::memory_order_relaxed);
+		::eventfd_write(*roomBell->handle(), 1);
+	}
+	public:
+		static std::shared_ptr<IpcResource> make(Yengine* e, IpcLayout* l, size_t m, unsigned end, IOResource db, IOResource rb, fd_t dr, fd_t rr, IOResource alive){
+			auto r = std::shared_ptr<IpcResource>(new IpcResource(e, l, m, end, db, rb, dr, rr));
+			r->setSelf(r);
+			r->alive = alive;
+			//the peer never writes, the read ends when its last liveness descriptor is closed
+			std::weak_ptr<IpcResource> w = r;
+			*e <<= alive->read<std::vector<char>>(1) >> [w](IAIOResource::ReadResult){
+				if(auto r = w.lock()) r->peerGone();
+			};
+			return r;
+		}
+		~IpcResource(){
+			alive->cancel();
+			out.writerGone.store(1, std::memory_order_release);
+			out.readerParked.store(0, std::memory_order_relaxed);
+			::eventfd_write(dataRing, 1);
+			in.readerGone.store(1, std::memory_order_release);
+			in.writerParked.store(0, std::memory_order_relaxed);
+			::eventfd_write(roomRing, 1);
+			::munmap(layout, mapped);
+			::close(dataRing);
+			::close(roomRing);
+		}
+		void cancel() override {
+			dataBell->cancel();
+			roomBell->cancel();
+		}
+		Future<ReadResult> _read(size_t bytes = 0) override {
+			struct Reading {
+				std::vector<char> data;
+				std::optional<Future<ReadResult>> bell;
+			};
+			return defer(lambdagen([this, self = slf.lock(), bytes](const Yengine*, bool& done, Reading& r) -> Generesume<ReadResult> {
+				if(done) return ReadResult::Ok(std::move(r.data));
+				if(r.bell){
+					auto res = r.bell->result();
+					r.bell = std::nullopt;
+					if(auto err = res.err()){
+						done = true;
+						return ReadResult::Err(*err);
+					}
+				}
+				while(true){
+					//whatever was written before the writer left is still to be read
+					bool gone = in.writerGone.load(std::memory_order_acquire);
+					if(in.ring.pop(inData, cap, r.data) > 0) wake(in.writerParked, roomRing);
+					if((bytes > 0 && r.data.size() >= bytes) || (gone && in.ring.empty())){
+						done = true;
+						return ReadResult::Ok(std::move(r.data));
+					}
+					if(park(in.readerParked, [this](){ return !in.ring.empty() || in.writerGone.load(std::memory_order_acquire); })) return *(r.bell = dataBell->read<std::vector<char>>(sizeof(eventfd_t)));
+				}
+			}, Reading{}));
+		}
+		Future<WriteResult> _write(std::vector<char>&& data) override {
+			return _writev(OutboundQueue(std::move(data)));
+		}
+		Future<WriteResult> _writev(OutboundQueue&& data) override {
+			struct Writing {
+				OutboundQueue q;
+				std::optional<Future<ReadResult>> bell;
+			};
+			return defer(lambdagen([this, self = slf.lock()](const Yengine*, bool& done, Writing& w) -> Generesume<WriteResult> {
+				if(done) return WriteResult::Ok();
+				if(w.bell){
+					auto res = w.bell->result();
+					w.bell = std::nullopt;
+					if(auto err = res.err()){
+						done = true;
+						return WriteResult::Err(*err);
+					}
+				}
+				while(!w.q.empty()){
+					if(out.readerGone.load(std::memory_order_acquire)){
+						done = true;
+						return WriteResult::Err("The other end is gone");
+					}
+					if(auto n = out.ring.push(outData, cap, w.q.frontData(), w.q.frontSize())){
+						w.q.advance(n);
+						wake(out.readerParked, dataRing);
+						continue;
+					}
+					//full, wait for the reader to make room
+					if(park(out.writerParked, [this](){ return !out.ring.full(cap) || out.readerGone.load(std::memory_order_acquire); })) return *(w.bell = roomBell->read<std::vector<char>>(sizeof(eventfd_t)));
+				}
+				done = true;
+				return WriteResult::Ok();
+			}, Writing{std::move(data), std::nullopt}));
+		}
+};
+
+IpcOpenResult ipcOpen(IOYengine* io, const IpcChannel& channel, unsigned end){
+	//own copies, so that both ends may be opened from the same descriptors
+	IpcChannel ch;
+	auto fail = [&ch](SysError err){
+		ch.close();
+		return IpcOpenResult::Err(err);
+	};
+	if(end > 1) return fail(SysError("No such channel end"));
+	for(size_t i = 0; i < ch.bells.size(); i++) if((ch.bells[i] = ::fcntl(channel.bells[i], F_DUPFD_CLOEXEC, 0)) < 0) return fail(SysError::last("Doorbell duplication failed"));
+	if((ch.alive[end] = ::fcntl(channel.alive[end], F_DUPFD_CLOEXEC, 0)) < 0) return fail(SysError::last("Liveness socket duplication failed"));
+	struct ::stat st;
+	if(::fstat(channel.memory, &st)) return fail(SysError::last("Shared memory stat failed"));
+	size_t size = st.st_size;
+	if(size < IPC_DATA_OFFSET) return fail(SysError("Not an IPC channel"));
+	auto mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, channel.memory, 0);
+	if(mem == MAP_FAILED) return fail(SysError::last("Shared memory mapping failed"));
+	auto layout = reinterpret_cast<IpcLayout*>(mem);
+	if(layout->magic != IPC_MAGIC || IPC_DATA_OFFSET + 2*layout->capacity != size){
+		::munmap(mem, size);
+		return fail(SysError("Not an IPC channel"));
+	}
+	unsigned inDir = 1-end, outDir = end;
+	auto dataBell = io->taek(HandledResource(new IpcDescriptor(ch.bells[2*inDir])));
+	auto roomBell = io->taek(HandledResource(new IpcDescriptor(ch.bells[2*outDir+1])));
+	auto alive = io->taek(HandledResource(new IpcDescriptor(ch.alive[end])));
+	return IpcOpenResult::Ok(IpcResource::make(io->engine, layout, size, end, dataBell, roomBell, ch.bells[2*outDir], ch.bells[2*inDir+1], alive));
+}
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "io.hpp"
+
+#ifndef _WIN32
+
+namespace yasync::io {
+
+constexpr size_t DEFAULT_IPC_CAPACITY = 1 << 20;
+
+/**
+ * Descriptors of a shared memory IPC channel: memory holding a lock-free ring per direction, and eventfd doorbells.
+ * Either end may be opened in this process, or the descriptors handed over to another process (a child) to open it there.
+ * Close the descriptors in each process once done opening ends from them - a peer is seen as gone only once no process holds its end's liveness descriptor.
+ */
+struct IpcChannel {
+	fd_t memory = -1;
+	/// Per direction: data available, room available
+	std::array<fd_t, 4> bells = {-1, -1, -1, -1};
+	/// Per end: socket that hangs up on the other end once the process holding it dies
+	std::array<fd_t, 2> alive = {-1, -1};
+	/**
+	 * Lets the descriptors survive exec, for a child to inherit them
+	 */
+	IpcChannel& inheritable(bool inherit = true);
+	/**
+	 * Textual form of the descriptors, to pass on to a child (as an argument, or in the environment)
+	 */
+	std::string str() const;
+	static std::optional<IpcChannel> parse(const std::string& s);
+	/**
+	 * Closes the descriptors, for a process that does not open an end (any more)
+	 */
+	void close();
+};
+
+using IpcCreateResult = result<IpcChannel, SysError>;
+/**
+ * Creates the shared memory and the doorbells of a channel.
+ * @param capacity bytes in flight per direction, rounded up to a power of 2
+ */
+IpcCreateResult ipcCreate(size_t capacity = DEFAULT_IPC_CAPACITY);
+
+using IpcOpenResult = result<IOResource, SysError>;
+/**
+ * Opens an end of the channel.
+ * Data moves through the shared rings without syscalls, doorbells are rung only when the other side waits (for data, or room).
+ * Closing an end ends the stream for the other one, and fails its writes. So does the peer process dying without closing.
+ * Each end supports one reader and one writer at a time.
+ * @param channel the end takes its own copies of the descriptors, the channel's stay with the caller
+ * @param end `0` or `1`, each end is opened once (across all the processes)
+ */
+IpcOpenResult ipcOpen(IOYengine*, const IpcChannel& channel, unsigned end);
+
+}
+
+#endif
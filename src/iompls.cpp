@@ -1,7 +1,9 @@
 #include "iompls.hpp"
 
 #include "util.hpp"
+#include "spscring.hpp"
 #include <mutex>
+#include <array>
 
 namespace yasync::io {
 
@@ -42,14 +44,14 @@ class IOI2Way {
 			void notify(IOCompletionInfo) override {}
 			void cancel() override {}
 			Future<ReadResult> _read(size_t bytes = 0) override {
-				return defer(lambdagen([this, self = slf.lock(), bytes](const Yengine*, bool& done, std::vector<char> data) -> Generesume<ReadResult> {
-					if(done) return ReadResult::Ok(data);
+				return defer(lambdagen([this, self = slf.lock(), bytes](const Yengine*, bool& done, std::vector<char>& data) -> Generesume<ReadResult> {
+					if(done) return ReadResult::Ok(std::move(data));
 					share->notifi[R] = std::nullopt;
 					std::unique_lock lk(share->locks[R]);
 					MoveAppend(share->buff[R], data);
 					if((bytes > 0 && data.size() >= bytes) || !share->exi[R]){
 						done = true;
-						return ReadResult::Ok(data);
+						return ReadResult::Ok(std::move(data));
 					}
 					return AFuture(*(share->notifi[R] = std::make_shared<OutsideFuture<void>>()));
 				}, std::vector<char>()));
@@ -78,5 +80,137 @@ std::pair<IOResource, IOResource> ioi2Way(Yengine* e1, Yengine* e2){
 	return IOI2Way::newt(e1, e2);
 }
 
+class IOIRing {
+	/**
+	 * One direction.
+	 * Data moves through the ring without locking, the lock only guards parking of a side that has to wait.
+	 */
+	struct Channel {
+		SpscRing ring;
+		std::atomic<bool> writerGone = false, readerGone = false;
+		std::mutex parking;
+		std::atomic<bool> readerParked = false, writerParked = false;
+		std::shared_ptr<OutsideFuture<void>> readerWait, writerWait;
+		Yengine* readerEngine = nullptr;
+		Yengine* writerEngine = nullptr;
+		Channel(size_t capacity) : ring(capacity) {}
+		/**
+		 * Parks a side, unless it became ready meanwhile
+		 * @returns future to await, none if ready
+		 */
+		template<typename Ready> std::shared_ptr<OutsideFuture<void>> park(std::atomic<bool>& parked, std::shared_ptr<OutsideFuture<void>>& wait, Ready ready){
+			auto f = std::make_shared<OutsideFuture<void>>();
+			{
+				std::unique_lock lk(parking);
+				wait = f;
+				parked.store(true, std::memory_order_relaxed);
+			}
+			//pairs with the fence in wake, either we see the other side's progress, or it sees us parked
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(ready()){
+				std::unique_lock lk(parking);
+				if(wait == f){
+					wait = nullptr;
+					parked.store(false, std::memory_order_relaxed);
+					return nullptr;
+				}
+				//already being woken up
+			}
+			return f;
+		}
+		void wake(std::atomic<bool>& parked, std::shared_ptr<OutsideFuture<void>>& wait, Yengine* via){
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(!parked.load(std::memory_order_relaxed)) return;
+			std::shared_ptr<OutsideFuture<void>> f;
+			{
+				std::unique_lock lk(parking);
+				std::swap(f, wait);
+				parked.store(false, std::memory_order_relaxed);
+			}
+			if(f && via){
+				f->completed();
+				via->notify(f);
+			}
+		}
+		inline void wakeReader(){ wake(readerParked, readerWait, readerEngine); }
+		inline void wakeWriter(){ wake(writerParked, writerWait, writerEngine); }
+	};
+	/// Channel R is read by end R
+	std::array<std::unique_ptr<Channel>, 2> chan;
+	template<unsigned R, unsigned W> class IOI : public IAIOResource {
+		friend class IOIRing;
+		std::shared_ptr<IOIRing> share;
+		IOI(Yengine* e, std::shared_ptr<IOIRing> p) : IAIOResource(e), share(p) {
+			share->chan[R]->readerEngine = e;
+			share->chan[W]->writerEngine = e;
+		}
+		public:
+			~IOI(){
+				auto& out = *share->chan[W];
+				out.writerGone.store(true, std::memory_order_release);
+				out.wakeReader();
+				auto& in = *share->chan[R];
+				in.readerGone.store(true, std::memory_order_release);
+				in.wakeWriter();
+			}
+			void notify(IOCompletionInfo) override {}
+			void cancel() override {}
+			Future<ReadResult> _read(size_t bytes = 0) override {
+				return defer(lambdagen([this, self = slf.lock(), bytes](const Yengine*, bool& done, std::vector<char>& data) -> Generesume<ReadResult> {
+					if(done) return ReadResult::Ok(std::move(data));
+					auto& c = *share->chan[R];
+					while(true){
+						//whatever was written before the writer left is still to be read
+						bool gone = c.writerGone.load(std::memory_order_acquire);
+						if(c.ring.pop(data) > 0) c.wakeWriter();
+						if((bytes > 0 && data.size() >= bytes) || (gone && c.ring.empty())){
+							done = true;
+							return ReadResult::Ok(std::move(data));
+						}
+						if(auto f = c.park(c.readerParked, c.readerWait, [&c](){ return !c.ring.empty() || c.writerGone.load(std::memory_order_acquire); })) return AFuture(f);
+					}
+				}, std::vector<char>()));
+			}
+			Future<WriteResult> _write(std::vector<char>&& data) override {
+				return _writev(OutboundQueue(std::move(data)));
+			}
+			Future<WriteResult> _writev(OutboundQueue&& data) override {
+				return defer(lambdagen([this, self = slf.lock()](const Yengine*, bool& done, OutboundQueue& q) -> Generesume<WriteResult> {
+					if(done) return WriteResult::Ok();
+					auto& c = *share->chan[W];
+					while(!q.empty()){
+						if(c.readerGone.load(std::memory_order_acquire)){
+							done = true;
+							return WriteResult::Err("The other end is gone");
+						}
+						if(auto n = c.ring.push(q.frontData(), q.frontSize())){
+							q.advance(n);
+							c.wakeReader();
+							continue;
+						}
+						//full, wait for the reader to make room
+						if(auto f = c.park(c.writerParked, c.writerWait, [&c](){ return !c.ring.full() || c.readerGone.load(std::memory_order_acquire); })) return AFuture(f);
+					}
+					done = true;
+					return WriteResult::Ok();
+				}, std::move(data)));
+			}
+	};
+	public:
+		static std::pair<IOResource, IOResource> newt(Yengine* e1, Yengine* e2, size_t capacity){
+			auto p = std::shared_ptr<IOIRing>(new IOIRing());
+			p->chan[0].reset(new Channel(capacity));
+			p->chan[1].reset(new Channel(capacity));
+			auto i1 = std::shared_ptr<IOI<0, 1>>(new IOI<0, 1>(e1, p));
+			auto i2 = std::shared_ptr<IOI<1, 0>>(new IOI<1, 0>(e2, p));
+			i1->setSelf(i1);
+			i2->setSelf(i2);
+			return std::pair<IOResource, IOResource>{i1,i2};
+		}
+};
+
+std::pair<IOResource, IOResource> ioi2WayRing(Yengine* e1, Yengine* e2, size_t capacity){
+	return IOIRing::newt(e1, e2, capacity);
 }
 
+}
@@ -20,4 +20,17 @@ std::pair<IOResource, IOResource> ioi2Way(Yengine*, Yengine*);
  */
 inline std::pair<IOResource, IOResource> ioi2Way(Yengine* engine){ return ioi2Way(engine, engine); }
 
+/**
+ * Creates a 2-way virtual IOI over bounded lock-free rings.
+ * Everything written to one end can be read from the other and the other way around.
+ * At most `capacity` bytes per direction are in flight, writes wait for the reader to make room.
+ * Each direction supports one reader and one writer at a time. Writes fail once the other end is gone.
+ */
+std::pair<IOResource, IOResource> ioi2WayRing(Yengine*, Yengine*, size_t capacity = 1 << 16);
+/**
+ * Creates a 2-way virtual IOI over bounded lock-free rings.
+ * @see ioi2WayRing(Yengine*, Yengine*, size_t)
+ */
+inline std::pair<IOResource, IOResource> ioi2WayRing(Yengine* engine, size_t capacity = 1 << 16){ return ioi2WayRing(engine, engine, capacity); }
+
 }
@@ -0,0 +1,234 @@
+#include "iopool.hpp"
+
+namespace yasync::io {
+
+using Endpoint = std::pair<std::string, std::string>;
+using AcquireFuture = std::shared_ptr<OutsideFuture<AcquireResult>>;
+
+struct ConnectionPool::Core {
+	struct Idle {
+		IOResource conn;
+		TickTack::TimePoint since;
+	};
+	struct Host {
+		/// Most recently given back last, so that the ones used least expire
+		std::vector<Idle> idle;
+		/// Idle, in use, and being established
+		unsigned open = 0;
+		std::deque<AcquireFuture> waiting;
+	};
+	IOYengine* engine;
+	TickTack* timer;
+	ConnectionPoolConfig config;
+	std::weak_ptr<Core> slf;
+	std::mutex lock;
+	std::map<Endpoint, Host> hosts;
+	bool closed = false;
+	unsigned long long hits = 0, misses = 0, waited = 0, evicted = 0, unhealthy = 0, failed = 0;
+	TickTack::Id sweeper = TickTack::UnId;
+	Core(IOYengine* e, TickTack* t, const ConnectionPoolConfig& c) : engine(e), timer(t), config(c) {}
+	static bool healthy(const IOResource& conn){
+		#ifndef _WIN32
+		auto h = conn->handle();
+		if(!h) return true;
+		char c;
+		auto n = ::recv(*h, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+		//nothing to read and no error - anything else is a closed peer, a reset, or an unread leftover
+		return n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN);
+		#else
+		return true;
+		#endif
+	}
+	Future<ConnectionResult> connect(const Endpoint& ep){
+		auto engine = this->engine;
+		auto options = config.connect;
+		return NetworkedAddressInfo::findAsync<AF_UNSPEC, SOCK_STREAM, IPPROTO_TCP>(engine->engine, ep.first, ep.second) >> [engine, options](NetworkedAddressInfo::FindResult found) -> Future<ConnectionResult> {
+			if(auto err = found.err()) return completed(ConnectionResult::Err(*err));
+			auto cs = netConnectTo<AF_UNSPEC, SOCK_STREAM, IPPROTO_TCP, ::sockaddr_storage>(engine, &*found.ok(), options);
+			if(auto err = cs.err()) return completed(ConnectionResult::Err(*err));
+			return (*cs.ok())->connest();
+		};
+	}
+	/// Lease of a fresh connection, or its place freed up
+	AcquireResult settle(const Endpoint& ep, ConnectionResult && r){
+		if(auto conn = r.ok()) return AcquireResult::Ok(PooledConnection(slf.lock(), ep, std::move(*conn)));
+		{
+			std::unique_lock lok(lock);
+			failed++;
+		}
+		drop(ep);
+		return AcquireResult::Err(*r.err());
+	}
+	/// Establishes a connection for the waiting acquisition, in the place freed up
+	void refill(const Endpoint& ep, AcquireFuture waiter){
+		auto self = slf.lock();
+		*engine->engine <<= connect(ep) >> [self, ep, waiter](ConnectionResult r){
+			waiter->completed(self->settle(ep, std::move(r)));
+			self->engine->engine->notify(waiter);
+		};
+	}
+	Future<AcquireResult> acquire(const Endpoint& ep){
+		std::vector<IOResource> broken;
+		auto waiter = std::make_shared<OutsideFuture<AcquireResult>>();
+		{
+			std::unique_lock lok(lock);
+			if(closed) return completed(AcquireResult::Err("Connection pool is closed"));
+			auto& host = hosts[ep];
+			while(!host.idle.empty()){
+				auto conn = std::move(host.idle.back().conn);
+				host.idle.pop_back();
+				if(healthy(conn)){
+					hits++;
+					lok.unlock();
+					return completed(AcquireResult::Ok(PooledConnection(slf.lock(), ep, std::move(conn))));
+				}
+				unhealthy++;
+				host.open--;
+				broken.push_back(std::move(conn));
+			}
+			if(host.open >= std::max(config.maxPerHost, 1u)){
+				waited++;
+				host.waiting.push_back(waiter);
+				return waiter;
+			}
+			misses++;
+			host.open++;
+		}
+		auto self = slf.lock();
+		return connect(ep) >> [self, ep](ConnectionResult r){ return self->settle(ep, std::move(r)); };
+	}
+	/// Takes a connection back, handing it straight to a waiting acquisition if there is one
+	void put(const Endpoint& ep, IOResource && conn){
+		AcquireFuture waiter;
+		{
+			std::unique_lock lok(lock);
+			auto& host = hosts[ep];
+			if(closed){
+				host.open--;
+				return;
+			}
+			if(host.waiting.empty()){
+				host.idle.push_back({std::move(conn), TickTack::Clock::now()});
+				return;
+			}
+			hits++;
+			waiter = std::move(host.waiting.front());
+			host.waiting.pop_front();
+		}
+		waiter->completed(AcquireResult::Ok(PooledConnection(slf.lock(), ep, std::move(conn))));
+		engine->engine->notify(waiter);
+	}
+	/// Frees up a place, filling it for a waiting acquisition if there is one
+	void drop(const Endpoint& ep){
+		AcquireFuture waiter;
+		{
+			std::unique_lock lok(lock);
+			auto& host = hosts[ep];
+			if(host.waiting.empty()){
+				host.open--;
+				return;
+			}
+			waiter = std::move(host.waiting.front());
+			host.waiting.pop_front();
+		}
+		refill(ep, waiter);
+	}
+	void sweep(){
+		std::vector<IOResource> expired;
+		{
+			std::unique_lock lok(lock);
+			auto before = TickTack::Clock::now() - config.idleTimeout;
+			for(auto it = hosts.begin(); it != hosts.end();){
+				auto& idle = it->second.idle;
+				//oldest first
+				size_t n = 0;
+				while(n < idle.size() && idle[n].since <= before) n++;
+				for(size_t i = 0; i < n; i++) expired.push_back(std::move(idle[i].conn));
+				idle.erase(idle.begin(), idle.begin() + n);
+				it->second.open -= n;
+				evicted += n;
+				if(it->second.open == 0 && it->second.waiting.empty()) it = hosts.erase(it);
+				else ++it;
+			}
+		}
+	}
+	void close(){
+		std::vector<IOResource> idle;
+		std::vector<AcquireFuture> waiting;
+		{
+			std::unique_lock lok(lock);
+			closed = true;
+			for(auto& [ep, host] : hosts){
+				for(auto& i : host.idle) idle.push_back(std::move(i.conn));
+				host.open -= host.idle.size();
+				host.idle.clear();
+				waiting.insert(waiting.end(), host.waiting.begin(), host.waiting.end());
+				host.waiting.clear();
+			}
+		}
+		for(auto& w : waiting){
+			w->completed(AcquireResult::Err("Connection pool is closed"));
+			engine->engine->notify(w);
+		}
+	}
+	ConnectionPoolStats stats(){
+		std::unique_lock lok(lock);
+		ConnectionPoolStats s{hits, misses, waited, evicted, unhealthy, failed, 0, 0, 0};
+		for(auto& [ep, host] : hosts){
+			s.idle += host.idle.size();
+			s.busy += host.open - host.idle.size();
+			s.waiting += host.waiting.size();
+		}
+		return s;
+	}
+};
+
+ConnectionPool::ConnectionPool(IOYengine* engine, TickTack* timer, const ConnectionPoolConfig& config) : core(std::make_shared<Core>(engine, timer, config)) {
+	core->slf = core;
+	if(timer && config.idleTimeout > TickTack::Duration::zero()){
+		//idle connections go within 1¼ of the timeout
+		std::weak_ptr<Core> w = core;
+		core->sweeper = timer->timer(std::max<TickTack::Duration>(config.idleTimeout / 4, std::chrono::milliseconds(10)), [w](TickTack::Id, bool cancelled){
+			if(cancelled) return;
+			if(auto c = w.lock()) c->sweep();
+		});
+	}
+}
+ConnectionPool::~ConnectionPool(){
+	if(core->sweeper != TickTack::UnId) core->timer->stop(core->sweeper);
+	core->close();
+}
+
+Future<AcquireResult> ConnectionPool::acquire(const std::string& host, const std::string& port){
+	return core->acquire(Endpoint(host, port));
+}
+ConnectionPoolStats ConnectionPool::stats(){
+	return core->stats();
+}
+
+PooledConnection::PooledConnection(const std::shared_ptr<ConnectionPool::Core>& p, const Endpoint& ep, IOResource&& c) : pool(p), endpoint(ep), conn(std::move(c)) {}
+PooledConnection& PooledConnection::operator=(PooledConnection&& mov){
+	discard();
+	pool = std::move(mov.pool);
+	endpoint = std::move(mov.endpoint);
+	conn = std::move(mov.conn);
+	return *this;
+}
+PooledConnection::~PooledConnection(){
+	discard();
+}
+
+void PooledConnection::release(){
+	if(!conn) return;
+	auto p = std::move(pool);
+	p->put(endpoint, std::move(conn));
+	conn.reset(); //unless taken back
+}
+void PooledConnection::discard(){
+	if(!conn) return;
+	auto p = std::move(pool);
+	conn.reset();
+	p->drop(endpoint);
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "iodns.hpp"
+
+#include <deque>
+
+namespace yasync::io {
+
+struct ConnectionPoolConfig {
+	using Duration = TickTack::Duration;
+	/// Connections per endpoint at most - idle, in use and being established. Acquiring beyond waits
+	unsigned maxPerHost = 8;
+	/// Idle connections are closed after this long, `0` to keep them
+	Duration idleTimeout = std::chrono::seconds(30);
+	/// How new connections are established
+	ConnectOptions connect = ConnectOptions();
+};
+
+struct ConnectionPoolStats {
+	/// Acquisitions served by an idle connection, and by a new one
+	unsigned long long hits, misses;
+	/// Acquisitions that had to wait for a connection to free up
+	unsigned long long waited;
+	/// Idle connections closed for being idle too long, and for failing the check on checkout
+	unsigned long long evicted, unhealthy;
+	/// Connections that could not be established
+	unsigned long long failed;
+	/// Connections idle, in use (or being established), and acquisitions waiting
+	size_t idle, busy, waiting;
+};
+
+class PooledConnection;
+using AcquireResult = result<PooledConnection, SysError>;
+
+/**
+ * Outbound connections kept open for reuse, per endpoint (host and port).
+ * Idle connections are checked on checkout - ones the peer closed, or that have unread data, are dropped for another.
+ */
+class ConnectionPool {
+	public:
+		struct Core;
+	private:
+		std::shared_ptr<Core> core;
+	public:
+		/**
+		 * @param engine engine to connect in
+		 * @param timer timer evicting idle connections, none are evicted without it
+		 */
+		ConnectionPool(IOYengine* engine, TickTack* timer, const ConnectionPoolConfig& config = ConnectionPoolConfig());
+		ConnectionPool(const ConnectionPool&) = delete;
+		ConnectionPool& operator=(const ConnectionPool&) = delete;
+		/**
+		 * Closes idle connections, and fails waiting acquisitions. Connections in use are closed as they're given back.
+		 */
+		~ConnectionPool();
+		/**
+		 * Connection to the endpoint - an idle one, a new one if under the limit, or the first one given back otherwise
+		 */
+		Future<AcquireResult> acquire(const std::string& host, const std::string& port);
+		ConnectionPoolStats stats();
+};
+
+/**
+ * Connection out of a pool.
+ * Give it back with @ref release once done and in a clean state (no response left unread), otherwise it is closed.
+ */
+class PooledConnection {
+	std::shared_ptr<ConnectionPool::Core> pool;
+	std::pair<std::string, std::string> endpoint;
+	IOResource conn;
+	friend struct ConnectionPool::Core;
+	PooledConnection(const std::shared_ptr<ConnectionPool::Core>& p, const std::pair<std::string, std::string>& ep, IOResource&& c);
+	public:
+		PooledConnection() = default;
+		PooledConnection(const PooledConnection&) = delete;
+		PooledConnection& operator=(const PooledConnection&) = delete;
+		PooledConnection(PooledConnection&&) = default;
+		PooledConnection& operator=(PooledConnection&& mov);
+		~PooledConnection();
+		inline const IOResource& operator*() const { return conn; }
+		inline IAIOResource* operator->() const { return conn.get(); }
+		inline explicit operator bool() const { return static_cast<bool>(conn); }
+		/**
+		 * Gives the connection back for reuse
+		 */
+		void release();
+		/**
+		 * Closes the connection, freeing its place in the pool
+		 */
+		void discard();
+};
+
+}
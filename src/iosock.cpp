@@ -1,33 +1,97 @@
 #include "iosock.hpp"
 
 #include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#ifndef _WIN32
+#include <netinet/tcp.h>
+#endif
+
+#ifndef _WIN32
+/// Readiness waking readers, and writers
+constexpr uint32_t EPOLL_READ_READY = EPOLLIN | EPOLLERR | EPOLLHUP;
+constexpr uint32_t EPOLL_WRITE_READY = EPOLLOUT | EPOLLERR | EPOLLHUP;
+constexpr uint32_t EPOLL_CONNECTED = EPOLLOUT | EPOLLONESHOT;
+constexpr int SOCK_ASYNC = SOCK_NONBLOCK | SOCK_CLOEXEC;
+#endif
 
 namespace yasync::io {
 
 using namespace magikop;
 
-NetworkedAddressInfo::NetworkedAddressInfo(::addrinfo* ads) : addresses(ads) {}
+NetworkedAddressInfo::NetworkedAddressInfo(::addrinfo* ads, bool res) : resolved(res), addresses(ads) {}
+NetworkedAddressInfo::NetworkedAddressInfo() : NetworkedAddressInfo(nullptr) {}
 NetworkedAddressInfo::NetworkedAddressInfo(NetworkedAddressInfo && mov){
+	resolved = mov.resolved;
 	addresses = mov.addresses;
 	mov.addresses = nullptr;
 }
 NetworkedAddressInfo& NetworkedAddressInfo::operator=(NetworkedAddressInfo && mov){
-	if(addresses) ::freeaddrinfo(addresses);
+	this->~NetworkedAddressInfo();
+	resolved = mov.resolved;
 	addresses = mov.addresses;
 	mov.addresses = nullptr;
 	return *this;
 }
 NetworkedAddressInfo::~NetworkedAddressInfo(){
-	if(addresses) ::freeaddrinfo(addresses);
+	if(!addresses) return;
+	if(resolved) ::freeaddrinfo(addresses);
+	else while(addresses){
+		auto next = addresses->ai_next;
+		delete reinterpret_cast<::sockaddr_storage*>(addresses->ai_addr);
+		delete[] addresses->ai_canonname;
+		delete addresses;
+		addresses = next;
+	}
+	addresses = nullptr;
+}
+
+NetworkedAddressInfo NetworkedAddressInfo::clone() const {
+	::addrinfo* head = nullptr;
+	auto tail = &head;
+	for(auto ad = addresses; ad; ad = ad->ai_next){
+		auto cp = new ::addrinfo(*ad);
+		cp->ai_next = nullptr;
+		cp->ai_canonname = nullptr;
+		auto st = new ::sockaddr_storage{};
+		std::memcpy(st, ad->ai_addr, std::min<size_t>(ad->ai_addrlen, sizeof(::sockaddr_storage)));
+		cp->ai_addr = reinterpret_cast<::sockaddr*>(st);
+		if(ad->ai_canonname){
+			auto len = std::strlen(ad->ai_canonname) + 1;
+			cp->ai_canonname = new char[len];
+			std::memcpy(cp->ai_canonname, ad->ai_canonname, len);
+		}
+		*tail = cp;
+		tail = &cp->ai_next;
+	}
+	return NetworkedAddressInfo(head, false);
 }
 
 NetworkedAddressInfo::FindResult NetworkedAddressInfo::find(const std::string& addr, const std::string& port, const ::addrinfo& hints){
 	::addrinfo* ads;
 	auto err = ::getaddrinfo(addr.c_str(), port.c_str(), &hints, &ads);
-	if(err) return NetworkedAddressInfo::FindResult::Err(std::string(reinterpret_cast<const char*>(::gai_strerror(err))));
+	if(err) return NetworkedAddressInfo::FindResult::Err(SysError("Address resolution failed", err, describeResolverError));
 	return NetworkedAddressInfo::FindResult::Ok(NetworkedAddressInfo(ads));
 }
 
+#ifndef _WIN32
+NetworkedAddressInfo::FindResult NetworkedAddressInfo::local(const std::string& path, int type){
+	if(path.empty() || path.size() >= sizeof(::sockaddr_un::sun_path)) return NetworkedAddressInfo::FindResult::Err(SysError("Unix socket path is empty or too long"));
+	auto st = new ::sockaddr_storage{};
+	auto un = reinterpret_cast<::sockaddr_un*>(st);
+	un->sun_family = AF_UNIX;
+	std::memcpy(un->sun_path, path.data(), path.size());
+	auto ads = new ::addrinfo{};
+	ads->ai_family = AF_UNIX;
+	ads->ai_socktype = type;
+	ads->ai_addr = reinterpret_cast<::sockaddr*>(st);
+	//abstract names are exactly as long as given, paths are NUL terminated
+	ads->ai_addrlen = offsetof(::sockaddr_un, sun_path) + path.size() + (path[0] == '\0' ? 0 : 1);
+	return NetworkedAddressInfo::FindResult::Ok(NetworkedAddressInfo(ads, false));
+}
+#endif
+
 #ifdef _WIN32
 SystemNetworkingStateControl::mswsock SystemNetworkingStateControl::MSWSA = {};
 SystemNetworkingStateControl::SystemNetworkingStateControl(){
@@ -61,37 +125,237 @@ std::string printSysNetError(const std::string& message, sysneterr_t e){
 	return printSysError(message, syserr_t(e) /* FIXME */);
 }
 std::string printSysNetError(const std::string& message){ return printSysNetError(message, ::WSAGetLastError()); }
+sysneterr_t lastSysNetError(){ return ::WSAGetLastError(); }
 #else
 std::string printSysNetError(const std::string& message, sysneterr_t e){ return printSysError(message, e); }
 std::string printSysNetError(const std::string& message){ return printSysError(message); }
+sysneterr_t lastSysNetError(){ return lastSysError(); }
 #endif
+std::string describeResolverError(const char* message, syserr_t code){
+	return std::string(message) + ": " + reinterpret_cast<const char*>(::gai_strerror(code));
+}
+
+template<typename V> static inline bool setOption(SocketHandle sock, int level, int name, V value){
+	return ::setsockopt(sock, level, name, reinterpret_cast<const char*>(&value), sizeof(value)) == 0;
+}
 
+result<void, SysError> applySocketOptions(SocketHandle sock, const SocketOptions& options, SocketRole role){
+	using Result = result<void, SysError>;
+	#ifdef TCP_QUICKACK
+	//not sticky, and not inherited by accepted sockets
+	if(options.quickAck && !setOption<int>(sock, IPPROTO_TCP, TCP_QUICKACK, *options.quickAck)) return retSysNetError<Result>("socket set quick ack failed");
+	#endif
+	if(role == SocketRole::Accepted) return Result::Ok();
+	if(options.noDelay && !setOption<int>(sock, IPPROTO_TCP, TCP_NODELAY, *options.noDelay)) return retSysNetError<Result>("socket set no delay failed");
+	//buffers decide the window scale, which is settled by the handshake
+	if(options.sendBuffer && !setOption<int>(sock, SOL_SOCKET, SO_SNDBUF, *options.sendBuffer)) return retSysNetError<Result>("socket set send buffer failed");
+	if(options.receiveBuffer && !setOption<int>(sock, SOL_SOCKET, SO_RCVBUF, *options.receiveBuffer)) return retSysNetError<Result>("socket set receive buffer failed");
+	#ifdef SO_BUSY_POLL
+	if(options.busyPoll && !setOption<int>(sock, SOL_SOCKET, SO_BUSY_POLL, *options.busyPoll)) return retSysNetError<Result>("socket set busy poll failed");
+	#endif
+	if(auto& ka = options.keepAlive){
+		if(!setOption<int>(sock, SOL_SOCKET, SO_KEEPALIVE, 1)) return retSysNetError<Result>("socket set keep alive failed");
+		#if defined(TCP_KEEPIDLE) && defined(TCP_KEEPINTVL) && defined(TCP_KEEPCNT)
+		if(!setOption<int>(sock, IPPROTO_TCP, TCP_KEEPIDLE, static_cast<int>(ka->idle.count())) || !setOption<int>(sock, IPPROTO_TCP, TCP_KEEPINTVL, static_cast<int>(ka->interval.count())) || !setOption<int>(sock, IPPROTO_TCP, TCP_KEEPCNT, ka->count)) return retSysNetError<Result>("socket set keep alive probes failed");
+		#endif
+	}
+	if(options.fastOpen && *options.fastOpen > 0){
+		#ifdef TCP_FASTOPEN_CONNECT
+		if(role == SocketRole::Connecting && !setOption<int>(sock, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, 1)) return retSysNetError<Result>("socket set fast open connect failed");
+		#endif
+		#ifdef TCP_FASTOPEN
+		if(role == SocketRole::Listener && !setOption<int>(sock, IPPROTO_TCP, TCP_FASTOPEN, *options.fastOpen)) return retSysNetError<Result>("socket set fast open failed");
+		#endif
+	}
+	return Result::Ok();
+}
+
+#ifdef _WIN32
 void ConnectingSocket::notify(IOCompletionInfo inf){
 	redy->completed([&](){
-		#ifdef _WIN32
 		if(inf.status) return ConnRedyResult::Ok();
 		else if(inf.lerr == ERROR_OPERATION_ABORTED) return ConnRedyResult::Err("Operation cancelled");
 		else return retSysNetError<ConnRedyResult>("ConnectEx async failed", inf.lerr);
-		#else
-		if((inf & EPOLLHUP) != 0) return ConnRedyResult::Err("Operation cancelled");
-		else if((inf & EPOLLERR) != 0){
-			int serr = 0;
-			::socklen_t serrlen = sizeof(serr);
-			if(::getsockopt(sock->rh, SOL_SOCKET, SO_ERROR, reinterpret_cast<void*>(&serr), &serrlen) < 0) return retSysNetError<ConnRedyResult>("connect async failed, and trying to understand why failed too");
-			else return retSysNetError<ConnRedyResult>("connect async failed", serr);
-		} else if((inf & EPOLLOUT) != 0) return ConnRedyResult::Ok();
-		else return retSysNetError<ConnRedyResult>("connect async scramble skedable");
-		#endif
 	}());
 	engine->engine->notify(redy);
 }
 void ConnectingSocket::cancel(){
-	#ifdef _WIN32
 	CancelIoEx(sock->rh, overlapped());
-	#else
-	notify(EPOLLHUP);
-	#endif
 }
+#else
+/**
+ * Connection attempt to one of the candidates
+ */
+class ConnectingSocket::Attempt : public IResource {
+	ConnectingSocket* race;
+	size_t index;
+	void notify(IOCompletionInfo events) override { race->ready(index, events); }
+	public:
+		fd_t sock;
+		bool polled = false;
+		TickTack::Id timeout = TickTack::UnId;
+		Attempt(ConnectingSocket* r, size_t i, fd_t s) : race(r), index(i), sock(s) {}
+		void cancel() override {}
+		inline bool open() const { return sock >= 0; }
+		/**
+		 * Closes the socket, unless it was taken
+		 */
+		void close(ConnectingSocket* r){
+			if(timeout != TickTack::UnId) r->options.timer->stop(timeout);
+			timeout = TickTack::UnId;
+			if(!open()) return;
+			if(polled) ::epoll_ctl(r->engine->ioPo->rh, EPOLL_CTL_DEL, sock, nullptr);
+			::close(sock);
+			sock = -1;
+		}
+};
+
+ConnectingSocket::ConnectingSocket(IOYengine* e, const ConnectOptions& o) : engine(e->ticket()), options(o), redy(new OutsideFuture<ConnRedyResult>()) {}
+ConnectingSocket::~ConnectingSocket(){
+	std::unique_lock lk(racing);
+	if(staggered != TickTack::UnId) options.timer->stop(staggered);
+	for(auto& a : attempts) a->close(this);
+}
+
+result<void, SysError> ConnectingSocket::start(const NetworkedAddressInfo* addri){
+	std::vector<std::vector<Candidate>> families;
+	for(auto candidate = addri->addresses; candidate; candidate = candidate->ai_next){
+		Candidate c = {};
+		c.length = std::min<::socklen_t>(candidate->ai_addrlen, sizeof(c.address));
+		std::memcpy(&c.address, candidate->ai_addr, c.length);
+		c.family = candidate->ai_family;
+		c.type = candidate->ai_socktype;
+		c.protocol = candidate->ai_protocol;
+		auto f = std::find_if(families.begin(), families.end(), [&c](const std::vector<Candidate>& f){ return f.front().family == c.family; });
+		if(!options.interleave && !families.empty()) f = families.begin();
+		if(f == families.end()) families.emplace_back(1, c);
+		else f->push_back(c);
+	}
+	for(size_t i = 0, added = 1; added; i++){
+		added = 0;
+		for(auto& f : families) if(i < f.size()){
+			candidates.push_back(f[i]);
+			added++;
+		}
+	}
+	std::unique_lock lk(racing);
+	launch();
+	//nothing in flight, and nothing won: all of them failed right away
+	if(settled && !sock) return result<void, SysError>::Err(lastError ? *lastError : SysError("Exhausted address space"));
+	return result<void, SysError>::Ok();
+}
+
+void ConnectingSocket::launch(){
+	if(staggered != TickTack::UnId) options.timer->stop(staggered);
+	staggered = TickTack::UnId;
+	while(!settled){
+		if(attempts.size() >= candidates.size()){
+			if(pending == 0) settle(result<void, SysError>::Err(lastError ? *lastError : SysError("Exhausted address space")));
+			return;
+		}
+		auto& c = candidates[attempts.size()];
+		auto i = attempts.size();
+		fd_t s = ::socket(c.family, c.type | SOCK_ASYNC, c.protocol);
+		attempts.emplace_back(new Attempt(this, i, s));
+		auto& a = *attempts.back();
+		if(s < 0){
+			lastError = SysError::last("socket construction failed");
+			continue;
+		}
+		if(auto err = applySocketOptions(s, options.socket, SocketRole::Connecting).err()){
+			lastError = *err;
+			a.close(this);
+			continue;
+		}
+		if(::connect(s, reinterpret_cast<const ::sockaddr*>(&c.address), c.length) == 0){
+			sock = std::make_unique<AHandledStrayIOSocket>(s);
+			a.sock = -1;
+			settle(result<void, SysError>::Ok());
+			return;
+		}
+		if(errno != EINPROGRESS && errno != EAGAIN){
+			lastError = SysError::last("connect failed");
+			a.close(this);
+			continue;
+		}
+		::epoll_event epm;
+		epm.events = EPOLL_CONNECTED;
+		epm.data.ptr = static_cast<IResource*>(&a);
+		if(::epoll_ctl(engine->ioPo->rh, EPOLL_CTL_ADD, s, &epm) < 0){
+			lastError = SysError::last("epoll add failed");
+			a.close(this);
+			continue;
+		}
+		a.polled = true;
+		pending++;
+		if(!options.timer) return;
+		std::weak_ptr<ConnectingSocket> wself = slf;
+		if(options.attemptTimeout > TickTack::Duration::zero()) a.timeout = options.timer->after(options.attemptTimeout, [wself, i](TickTack::Id, bool cancelled){
+			if(cancelled) return;
+			if(auto self = wself.lock()) self->timedOut(i);
+		});
+		if(attempts.size() < candidates.size()) staggered = options.timer->after(options.stagger, [wself](TickTack::Id, bool cancelled){
+			if(cancelled) return;
+			if(auto self = wself.lock()){
+				std::unique_lock lk(self->racing);
+				self->staggered = TickTack::UnId;
+				self->launch();
+			}
+		});
+		return;
+	}
+}
+
+void ConnectingSocket::ready(size_t i, IOCompletionInfo events){
+	std::unique_lock lk(racing);
+	auto& a = *attempts[i];
+	if(settled || !a.open()) return;
+	int serr = 0;
+	::socklen_t serrlen = sizeof(serr);
+	if(::getsockopt(a.sock, SOL_SOCKET, SO_ERROR, reinterpret_cast<void*>(&serr), &serrlen) < 0) serr = errno;
+	else if(serr == 0 && (events & EPOLLOUT) == 0) serr = ECONNREFUSED;
+	if(serr != 0) return fail(i, SysError("connect async failed", serr));
+	if(a.timeout != TickTack::UnId) options.timer->stop(a.timeout);
+	a.timeout = TickTack::UnId;
+	sock = std::make_unique<AHandledStrayIOSocket>(a.sock, true);
+	a.sock = -1;
+	pending--;
+	settle(result<void, SysError>::Ok());
+}
+
+void ConnectingSocket::fail(size_t i, SysError err){
+	attempts[i]->close(this);
+	pending--;
+	lastError = err;
+	//no reason to wait out the head start, the next one starts right away (launch stops the stagger)
+	launch();
+}
+
+void ConnectingSocket::timedOut(size_t i){
+	std::unique_lock lk(racing);
+	auto& a = *attempts[i];
+	a.timeout = TickTack::UnId;
+	if(settled || !a.open()) return;
+	fail(i, SysError("connect timed out", ETIMEDOUT));
+}
+
+void ConnectingSocket::settle(result<void, SysError> && r){
+	settled = true;
+	if(staggered != TickTack::UnId) options.timer->stop(staggered);
+	staggered = TickTack::UnId;
+	for(auto& a : attempts) a->close(this);
+	pending = 0;
+	redy->completed(std::move(r));
+	engine->engine->notify(redy);
+}
+
+void ConnectingSocket::notify(IOCompletionInfo){} //attempts are notified instead
+void ConnectingSocket::cancel(){
+	std::unique_lock lk(racing);
+	if(!settled) settle(result<void, SysError>::Err("Operation cancelled"));
+}
+#endif
+
 Future<ConnectionResult> ConnectingSocket::connest(){
 	return redy >> ([=, self = slf.lock()](){
 		#ifdef _WIN32
@@ -101,4 +365,67 @@ Future<ConnectionResult> ConnectingSocket::connest(){
 	}|[](auto err){ return ConnectionResult::Err(err); });
 }
 
+#ifndef _WIN32
+ReadinessSocket::ReadinessSocket(IOYengine* e, fd_t s) : engine(e->ticket()), sock(s) {}
+ReadinessSocket::~ReadinessSocket(){
+	//the socket may live on elsewhere (duplicated, passed on), keeping the registration and its pointer to us
+	::epoll_ctl(engine->ioPo->rh, EPOLL_CTL_DEL, sock, nullptr);
+	::close(sock);
+}
+result<void, SysError> ReadinessSocket::poll(){
+	::epoll_event epm;
+	epm.events = EPOLLONESHOT;
+	epm.data.ptr = static_cast<IResource*>(this);
+	if(::epoll_ctl(engine->ioPo->rh, EPOLL_CTL_ADD, sock, &epm) < 0) return retSysError<result<void, SysError>>("epoll add failed");
+	return result<void, SysError>::Ok();
+}
+void ReadinessSocket::rearm(){
+	::epoll_event epm;
+	epm.events = EPOLLONESHOT;
+	if(!readable.empty()) epm.events |= EPOLLIN;
+	if(!writable.empty()) epm.events |= EPOLLOUT;
+	epm.data.ptr = static_cast<IResource*>(this);
+	::epoll_ctl(engine->ioPo->rh, EPOLL_CTL_MOD, sock, &epm);
+}
+void ReadinessSocket::notify(IOCompletionInfo events){
+	std::vector<std::shared_ptr<OutsideFuture<int>>> woken;
+	{
+		std::unique_lock lk(waiting);
+		if(events & EPOLL_READ_READY || events == 0) std::swap(woken, readable);
+		if(events & EPOLL_WRITE_READY || events == 0){
+			woken.insert(woken.end(), writable.begin(), writable.end());
+			writable.clear();
+		}
+		//the other direction is still waiting, one-shot disarmed it
+		if(!readable.empty() || !writable.empty()) rearm();
+	}
+	//all of them retry, those that still would block wait again
+	for(auto& n : woken){
+		n->completed(int(events));
+		engine->engine->notify(n);
+	}
+}
+Future<int> ReadinessSocket::ready(bool wr){
+	auto n = std::make_shared<OutsideFuture<int>>();
+	std::unique_lock lk(waiting);
+	if(closed){
+		n->completed(EPOLLHUP);
+		return n;
+	}
+	(wr ? writable : readable).push_back(n);
+	rearm();
+	return n;
+}
+void ReadinessSocket::shutdown(){
+	{
+		std::unique_lock lk(waiting);
+		closed = true;
+	}
+	notify(EPOLLHUP);
+}
+void ReadinessSocket::cancel(){
+	notify(0);
+}
+#endif
+
 }
@@ -16,20 +16,25 @@
 #include <sys/socket.h>
 #include <netinet/ip.h>
 #include <netdb.h>
+#include <sys/un.h>
 #endif
 
 namespace yasync::io {
 
 class NetworkedAddressInfo {
-	NetworkedAddressInfo(::addrinfo* ads);
+	NetworkedAddressInfo(::addrinfo* ads, bool resolved = true);
+	/// Addresses come from the resolver, rather than being built here
+	bool resolved;
 	public:
 		::addrinfo* addresses;
+		/// No addresses
+		NetworkedAddressInfo();
 		NetworkedAddressInfo(const NetworkedAddressInfo&) = delete;
 		NetworkedAddressInfo& operator=(const NetworkedAddressInfo&) = delete;
 		NetworkedAddressInfo(NetworkedAddressInfo &&);
 		NetworkedAddressInfo& operator=(NetworkedAddressInfo &&);
 		~NetworkedAddressInfo();
-		using FindResult = result<NetworkedAddressInfo, std::string>;
+		using FindResult = result<NetworkedAddressInfo, SysError>;
 		static FindResult find(const std::string& address, const std::string& port, const ::addrinfo& hints);
 		template<int SDomain, int SType, int SProto> static inline ::addrinfo hint(){
 			::addrinfo hints = {};
@@ -39,6 +44,24 @@ class NetworkedAddressInfo {
 			return hints;
 		}
 		template<int SDomain, int SType, int SProto> static FindResult find(const std::string& address, const std::string& port){ return find(address, port, hint<SDomain, SType, SProto>()); }
+		/**
+		 * Resolves off the engine, on the shared @ref Resolver - deduplicated and cached
+		 */
+		static Future<FindResult> findAsync(Yengine* engine, const std::string& address, const std::string& port, const ::addrinfo& hints);
+		template<int SDomain, int SType, int SProto> static Future<FindResult> findAsync(Yengine* engine, const std::string& address, const std::string& port){ return findAsync(engine, address, port, hint<SDomain, SType, SProto>()); }
+		/**
+		 * Deep copy of the addresses, owned by the copy
+		 */
+		NetworkedAddressInfo clone() const;
+		#ifndef _WIN32
+		/**
+		 * Unix domain socket address, to listen on or connect to (as `AF_UNIX`, `sockaddr_un`).
+		 * Binding does not replace a stale socket file, remove it first.
+		 * @param path filesystem path, or abstract name if it starts with a NUL
+		 * @param type `SOCK_STREAM` or `SOCK_SEQPACKET`
+		 */
+		static FindResult local(const std::string& path, int type = SOCK_STREAM);
+		#endif
 };
 
 #ifdef _WIN32
@@ -53,6 +76,22 @@ std::string printSysNetError(const std::string& message, sysneterr_t e);
 std::string printSysNetError(const std::string& message);
 template<typename R> R retSysNetError(const std::string& message, sysneterr_t e){ return R::Err(printSysNetError(message, e)); }
 template<typename R> R retSysNetError(const std::string& message){ return R::Err(printSysNetError(message)); }
+sysneterr_t lastSysNetError();
+/**
+ * @param message static message
+ */
+template<typename R> R retSysNetError(const char* message, sysneterr_t e){
+	if constexpr (std::is_same<typename R::ERR, SysError>::value) return R::Err(SysError(message, syserr_t(e)));
+	else return R::Err(printSysNetError(message, e));
+}
+/**
+ * @param message static message
+ */
+template<typename R> R retSysNetError(const char* message){ return retSysNetError<R>(message, lastSysNetError()); }
+/**
+ * Describes getaddrinfo failure codes
+ */
+std::string describeResolverError(const char* message, syserr_t code);
 
 class SystemNetworkingStateControl {
 	public:
@@ -73,10 +112,13 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs, typename Acc> using ListeningSocket = std::shared_ptr<AListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>>;
 
 class AHandledStrayIOSocket : public IHandledResource {
+	bool detached = false;
 	public:
 		inline SocketHandle sock() const { return SocketHandle(rh); }
 		AHandledStrayIOSocket(SocketHandle sock, bool iopor = false) : IHandledResource(ResourceHandle(sock), iopor){}
+		bool detach() override { return detached = true; }
 		~AHandledStrayIOSocket(){
+			if(detached) return;
 			#ifdef _WIN32
 			if(sock() != INVALID_SOCKET){
 				::shutdown(sock(), SD_BOTH);
@@ -92,6 +134,90 @@ class AHandledStrayIOSocket : public IHandledResource {
 };
 using HandledStrayIOSocket = std::unique_ptr<AHandledStrayIOSocket>;
 
+/**
+ * Accepted socket counted among the open connections of its listener
+ */
+class CountedStrayIOSocket : public AHandledStrayIOSocket {
+	std::shared_ptr<std::atomic<size_t>> open;
+	public:
+		CountedStrayIOSocket(SocketHandle sock) : AHandledStrayIOSocket(sock) {}
+		void count(std::shared_ptr<std::atomic<size_t>> counter){
+			open = std::move(counter);
+			open->fetch_add(1, std::memory_order_relaxed);
+		}
+		~CountedStrayIOSocket(){
+			if(open) open->fetch_sub(1, std::memory_order_relaxed);
+		}
+};
+
+/**
+ * What a listener does with connections while over a limit
+ */
+enum class ListenOverload {
+	/// Leaves them in the backlog, and retries after a pause
+	Pause,
+	/// Accepts and closes them right away
+	Shed,
+};
+
+/**
+ * Socket tuning. Unset options are left at the system defaults, options the platform lacks are ignored.
+ */
+struct SocketOptions {
+	/// TCP_NODELAY - small writes go out right away, instead of waiting for the previous ones to be acknowledged
+	std::optional<bool> noDelay;
+	/// TCP_QUICKACK - acknowledges right away, instead of waiting to piggyback on a response (Linux)
+	std::optional<bool> quickAck;
+	/// SO_SNDBUF and SO_RCVBUF, in bytes
+	std::optional<int> sendBuffer, receiveBuffer;
+	/// TCP_FASTOPEN - queue of pending fast open requests of a listener; any positive value makes connections try fast open - they complete right away, and handshake with the first write (Linux)
+	std::optional<int> fastOpen;
+	/// SO_BUSY_POLL - microseconds to busy poll the device for data on blocking receives (Linux)
+	std::optional<int> busyPoll;
+	struct KeepAlive {
+		/// Idle time before the first probe, time between probes
+		std::chrono::seconds idle, interval;
+		/// Unanswered probes before the connection is dropped
+		int count;
+	};
+	/// SO_KEEPALIVE, with TCP_KEEPIDLE, TCP_KEEPINTVL and TCP_KEEPCNT
+	std::optional<KeepAlive> keepAlive;
+};
+
+/**
+ * What the socket is, as that decides which options apply
+ */
+enum class SocketRole {
+	/// Listener, before binding - accepted sockets inherit its options (but quick ack)
+	Listener,
+	/// Accepted from a listener the options were applied to
+	Accepted,
+	/// Connecting, before connecting
+	Connecting,
+};
+
+/**
+ * Applies the options that apply to the socket role
+ */
+result<void, SysError> applySocketOptions(SocketHandle sock, const SocketOptions& options, SocketRole role);
+
+struct ListenOptions {
+	/// Length of the queue of pending connections
+	int backlog = 200;
+	/// Most connections accepted per wake-up, before letting other work run (epoll), at least one
+	unsigned acceptBudget = 64;
+	/// Limit of open connections accepted by the listener, `0` for unlimited
+	size_t maxConnections = 0;
+	/// Limit of the engine run queue depth, `0` for unlimited
+	size_t maxQueued = 0;
+	ListenOverload overload = ListenOverload::Pause;
+	/// Timer to pause with, without one overload sheds
+	TickTack* timer = nullptr;
+	TickTack::Duration pause = std::chrono::milliseconds(10);
+	/// Applied to the listener, and so to every accepted connection
+	SocketOptions socket = SocketOptions();
+};
+
 /**
  * @typeparam Errs (this, sysneterr_t, string) -> bool
  * @typeparam Acc (AddressInfo, IOResource) -> void
@@ -102,6 +228,8 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 		std::weak_ptr<AListeningSocket> slf;
 		auto setSelf(std::shared_ptr<AListeningSocket> self){ return slf = self; }
 		void close(){
+			if(options.timer && paused != TickTack::UnId) options.timer->stop(paused);
+			paused = TickTack::UnId;
 			#ifdef _WIN32
 			if(sock != INVALID_SOCKET) ::closesocket(sock);
 			sock = INVALID_SOCKET;
@@ -114,7 +242,7 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 		}
 	private:
 		enum class ListenEventType {
-			Close, Accept, Error
+			Close, Accept, Error, Resume
 		};
 		struct ListenEvent {
 			ListenEventType type;
@@ -141,7 +269,7 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 		}
 		void cancel() override {} //Doesn't make much sense...	Use shutdown to stop listening.
 		#ifdef _WIN32
-		HandledStrayIOSocket lconn;
+		std::unique_ptr<CountedStrayIOSocket> lconn;
 		struct InterlocInf {
 			struct PadAddr {
 				AddressInfo addr;
@@ -154,33 +282,115 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 		#endif
 		Errs erracc;
 		Acc acceptor;
+		ListenOptions options;
+		std::shared_ptr<std::atomic<size_t>> open = std::make_shared<std::atomic<size_t>>(0);
+		TickTack::Id paused = TickTack::UnId;
+		bool overloaded() const {
+			return (options.maxConnections > 0 && open->load(std::memory_order_relaxed) >= options.maxConnections) || (options.maxQueued > 0 && engine->engine->queued() >= options.maxQueued);
+		}
+		inline bool pausing() const { return options.overload == ListenOverload::Pause && options.timer; }
+		/// Resumes accepting after the pause
+		void pause(){
+			paused = options.timer->after(options.pause, [wself = slf](TickTack::Id, bool cancelled){
+				if(cancelled) return;
+				if(auto self = wself.lock()) self->notify(ListenEventType::Resume);
+			});
+		}
+		void accepted(const AddressInfo& remote, std::unique_ptr<CountedStrayIOSocket>&& conn){
+			applySocketOptions(conn->sock(), options.socket, SocketRole::Accepted); //a hint, the connection is fine without
+			conn->count(open);
+			acceptor(remote, engine->taek(HandledResource(std::move(conn))));
+		}
+		#ifndef _WIN32
+		enum class Drained {
+			Dry, Budget, Paused, Stop
+		};
+		/**
+		 * Accepts pending connections, up to the budget
+		 */
+		Drained drain(const std::shared_ptr<AListeningSocket>& self){
+			for(unsigned budget = std::max(options.acceptBudget, 1u); budget > 0; budget--){
+				fd_t conn;
+				AddressInfo remote;
+				::socklen_t remlen = sizeof(remote);
+				bool shed = overloaded();
+				if(shed && pausing()) return Drained::Paused;
+				conn = ::accept4(sock, reinterpret_cast<::sockaddr*>(&remote), &remlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+				if(conn >= 0){
+					if(shed) ::close(conn);
+					else accepted(remote, std::make_unique<CountedStrayIOSocket>(conn));
+					continue;
+				}
+				switch(errno){
+					#if EAGAIN != EWOULDBLOCK
+					case EWOULDBLOCK:
+					#endif
+					case EAGAIN: return Drained::Dry;
+					case ECONNABORTED:
+					case EINTR: break;
+					default: if(erracc(self, errno, "accept failed")) return Drained::Stop;
+				}
+			}
+			return Drained::Budget;
+		}
+		#endif
 	public:
 		IOYengine::Ticket engine;
 		AddressInfo address;
-		AListeningSocket(IOYengine* e, SocketHandle socket, Errs era, Acc accept) : sock(socket), engif(new OutsideFuture<ListenEvent>()), erracc(era), acceptor(accept), engine(e->ticket()) {
-			#ifdef _WIN32
-			
-			#else
-			#endif
+		AListeningSocket(IOYengine* e, SocketHandle socket, Errs era, Acc accept) : sock(socket), engif(new OutsideFuture<ListenEvent>()), erracc(era), acceptor(accept), engine(e->ticket()) {}
+		static std::shared_ptr<AListeningSocket> make(IOYengine* e, SocketHandle socket, Errs era, Acc accept){
+			auto ls = std::make_shared<AListeningSocket>(e, socket, era, accept);
+			ls->setSelf(ls);
+			return ls;
 		}
 		AListeningSocket(const AListeningSocket& cpy) = delete;
 		AListeningSocket(AListeningSocket&& mv) = delete;
 		~AListeningSocket(){
 			close();
 		}
-		using ListenResult = result<Future<void>, std::string>;
+		/**
+		 * Number of connections accepted by this listener that are still open
+		 */
+		inline size_t connections() const { return open->load(std::memory_order_relaxed); }
+		using ListenResult = result<Future<void>, SysError>;
 		/**
 		 * Starts listening
 		 * @returns future that will complete when the socket shutdowns, or errors.
 		 */
-		ListenResult listen(const NetworkedAddressInfo* addri){
+		ListenResult listen(const NetworkedAddressInfo* addri, const ListenOptions& opts = ListenOptions()){
+			options = opts;
+			if(auto err = applySocketOptions(sock, options.socket, SocketRole::Listener).err()) return ListenResult::Err(*err);
 			{
 				auto candidate = addri->addresses;
 				//https://stackoverflow.com/a/50227324
-				for(; candidate; candidate = candidate->ai_next) if(::bind(sock, candidate->ai_addr, candidate->ai_addrlen) == 0) if(::listen(sock, 200) == 0) break;
+				for(; candidate; candidate = candidate->ai_next) if(::bind(sock, candidate->ai_addr, candidate->ai_addrlen) == 0) if(::listen(sock, options.backlog) == 0) break;
 				if(!candidate) return ListenResult::Err("Exhausted address space");
 				address = *reinterpret_cast<AddressInfo*>(candidate->ai_addr);
+				bound();
 			}
+			return start();
+		}
+		/**
+		 * Starts listening on exactly the address
+		 * @returns future that will complete when the socket shutdowns, or errors.
+		 */
+		ListenResult listen(const AddressInfo& at, const ListenOptions& opts = ListenOptions()){
+			options = opts;
+			if(auto err = applySocketOptions(sock, options.socket, SocketRole::Listener).err()) return ListenResult::Err(*err);
+			if(::bind(sock, reinterpret_cast<const ::sockaddr*>(&at), sizeof(at)) != 0) return retSysNetError<ListenResult>("bind failed");
+			if(::listen(sock, options.backlog) != 0) return retSysNetError<ListenResult>("listen failed");
+			address = at;
+			bound();
+			return start();
+		}
+	private:
+		/// Picks up the port the system assigned, if any was
+		void bound(){
+			AddressInfo actual;
+			::socklen_t len = sizeof(actual);
+			if(::getsockname(sock, reinterpret_cast<::sockaddr*>(&actual), &len) == 0) address = actual;
+		}
+		ListenResult start(){
 			#ifdef _WIN32
 			// if(::listen(sock, 200) == SOCKET_ERROR) return retSysNetError<ListenResult>("WSA listen failed");
 			if(!CreateIoCompletionPort(reinterpret_cast<HANDLE>(sock), engine->ioPo->rh, COMPLETION_KEY_IO, 0)) return retSysError<ListenResult>("ioCP add failed");
@@ -201,6 +411,9 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 					close();
 					return monoid<void>();
 				};
+				#ifndef _WIN32
+				bool drained = false;
+				#endif
 				if(engif->state() == FutureState::Completed){
 					auto event = engif->running();
 					switch(event.type){
@@ -208,31 +421,19 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 							#ifdef _WIN32
 							if(::setsockopt(lconn->sock(), SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT, reinterpret_cast<char*>(&sock), sizeof(sock)) == SOCKET_ERROR){
 								if(erracc(self, ::WSAGetLastError(), "Set accepting socket accept failed")) return stahp();
-							} else acceptor(linterloc.remote.addr, engine->taek(HandledResource(std::move(lconn))));
+							} else if(overloaded()) lconn.reset();
+							else accepted(linterloc.remote.addr, std::move(lconn));
 							#else
-							bool goAsync = false;
-							while(!goAsync){
-								AddressInfo remote;
-								socklen_t remlen = sizeof(remote); 
-								while(true){
-									auto conn = ::accept(sock, reinterpret_cast<sockaddr*>(&remote), &remlen);
-									if(conn < 0) break;
-									acceptor(remote, engine->taek(HandledResource(HandledStrayIOSocket(new AHandledStrayIOSocket(conn)))));
-								}
-								switch(errno){
-									#if EAGAIN != EWOULDBLOCK
-									case EWOULDBLOCK:
-									#endif
-									case EAGAIN:
-										goAsync = true;
-										break;
-									case ECONNABORTED: break;
-									default: if(erracc(self, errno, "accept failed")) return stahp();
-								}
-							}
+							drained = true;
 							#endif
 							break;
 						}
+						case ListenEventType::Resume:
+							paused = TickTack::UnId;
+							#ifndef _WIN32
+							drained = true;
+							#endif
+							break;
 						case ListenEventType::Error:
 							if(erracc(self, event.err, "Async accept error")) return stahp();
 							break;
@@ -243,16 +444,21 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 				#ifdef _WIN32
 				bool goAsync = false;
 				while(!goAsync){
+					if(overloaded() && pausing()){
+						pause();
+						return AFuture(engif);
+					}
 					{
 						auto nconn = ::WSASocket(SDomain, SType, SProto, NULL, 0, WSA_FLAG_OVERLAPPED);
 						if(nconn == INVALID_SOCKET) if(erracc(self, ::WSAGetLastError(), "Create accepting socket failed") || true) return stahp();
-						lconn.reset(new AHandledStrayIOSocket(nconn));
+						lconn.reset(new CountedStrayIOSocket(nconn));
 					}
 					DWORD reclen;
 					if(SystemNetworkingStateControl::MSWSA.AcceptEx(sock, lconn->sock(), &linterloc, 0, sizeof(linterloc.local), sizeof(linterloc.remote), &reclen, overlapped())){
 						if(::setsockopt(lconn->sock(), SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT, reinterpret_cast<char*>(&sock), sizeof(sock)) == SOCKET_ERROR){
 							if(erracc(self, ::WSAGetLastError(), "Set accepting socket accept failed")) return stahp();
-						} else acceptor(linterloc.remote.addr, engine->taek(HandledResource(std::move(lconn))));
+						} else if(overloaded()) lconn.reset();
+						else accepted(linterloc.remote.addr, std::move(lconn));
 					}
 					else switch(::WSAGetLastError()){
 						case WSAEWOULDBLOCK:
@@ -264,6 +470,15 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 					}
 				}
 				#else
+				if(drained) switch(drain(self)){
+					case Drained::Stop: return stahp();
+					case Drained::Paused:
+						//stays out of epoll till the pause is over
+						pause();
+						return AFuture(engif);
+					case Drained::Budget: //the backlog is not empty, so the rearm wakes us right up again - after other queued work
+					case Drained::Dry: break;
+				}
 				{
 					::epoll_event epm;
 					epm.events = EPOLLIN|EPOLLONESHOT;
@@ -274,6 +489,7 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 				return AFuture(engif);
 			}, 0)));
 		}
+	public:
 		/**
 		 * Initiates shutdown sequence.
 		 * No new connections will be accepted from this point on. 
@@ -283,94 +499,244 @@ template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs
 		}
 };
 
-template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs, typename Acc> result<ListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>, std::string> netListen(IOYengine* engine, Errs erracc, Acc acceptor){
-	using LSock = ListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>;
+/**
+ * Creates a non-blocking socket ready to be bound for listening
+ * @param reusePort whether other sockets may bind to the same address, for the system to balance connections among them
+ */
+template<int SDomain, int SType, int SProto> result<SocketHandle, SysError> netListenSocket(bool reusePort = false){
+	using Result = result<SocketHandle, SysError>;
 	SocketHandle sock;
 	#ifdef _WIN32
+	if(reusePort) return Result::Err("Port reuse is not supported");
 	sock = ::WSASocket(SDomain, SType, SProto, NULL, 0, WSA_FLAG_OVERLAPPED);
-	if(sock == INVALID_SOCKET) return retSysError<result<LSock, std::string>>("WSA socket construction failed");
+	if(sock == INVALID_SOCKET) return retSysError<Result>("WSA socket construction failed");
 	#else
 	sock = ::socket(SDomain, SType, SProto);
-	if(sock < 0) return retSysError<result<LSock, std::string>>("socket construction failed");
+	if(sock < 0) return retSysError<Result>("socket construction failed");
+	auto fail = [sock](const char* msg){
+		auto err = SysError::last(msg);
+		::close(sock);
+		return Result::Err(err);
+	};
 	int reua = 1;
-	if(::setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<void*>(&reua), sizeof(reua)) < 0) return retSysError<result<LSock, std::string>>("socket set reuse address failed");
+	if(::setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<void*>(&reua), sizeof(reua)) < 0) return fail("socket set reuse address failed");
+	if(reusePort && ::setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<void*>(&reua), sizeof(reua)) < 0) return fail("socket set reuse port failed");
 	int fsf = fcntl(sock, F_GETFL, 0);
-	if(fsf < 0) return retSysError<result<LSock, std::string>>("socket get flags failed"); 
-	if(fcntl(sock, F_SETFL, fsf|O_NONBLOCK) < 0) return retSysError<result<LSock, std::string>>("socket set non-blocking failed");
+	if(fsf < 0) return fail("socket get flags failed");
+	if(fcntl(sock, F_SETFL, fsf|O_NONBLOCK) < 0) return fail("socket set non-blocking failed");
 	#endif
-	return result<LSock, std::string>::Ok(LSock(new AListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>(engine, sock, erracc, acceptor)));
+	return Result::Ok(sock);
 }
 
-using ConnectionResult = result<IOResource, std::string>;
+template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs, typename Acc> result<ListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>, SysError> netListen(IOYengine* engine, Errs erracc, Acc acceptor){
+	using LSock = ListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>;
+	auto sock = netListenSocket<SDomain, SType, SProto>();
+	if(auto err = sock.err()) return result<LSock, SysError>::Err(*err);
+	return result<LSock, SysError>::Ok(AListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>::make(engine, *sock.ok(), erracc, acceptor));
+}
+
+template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs, typename Acc> using ListeningShards = std::vector<ListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>>;
+
+/**
+ * Creates listening sockets that share the address (SO_REUSEPORT), one per IO engine. The system spreads incoming connections among them.
+ * Every shard accepts independently, and invokes its own copy of the callbacks, with itself, on its own engine.
+ * @param engines IO engine of each shard, may repeat
+ * @see listenShards
+ */
+template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs, typename Acc> result<ListeningShards<SDomain, SType, SProto, AddressInfo, Errs, Acc>, SysError> netListenSharded(const std::vector<IOYengine*>& engines, Errs erracc, Acc acceptor){
+	using Shards = ListeningShards<SDomain, SType, SProto, AddressInfo, Errs, Acc>;
+	Shards shards;
+	shards.reserve(engines.size());
+	for(auto engine : engines){
+		auto sock = netListenSocket<SDomain, SType, SProto>(true);
+		if(auto err = sock.err()) return result<Shards, SysError>::Err(*err);
+		shards.push_back(AListeningSocket<SDomain, SType, SProto, AddressInfo, Errs, Acc>::make(engine, *sock.ok(), erracc, acceptor));
+	}
+	return result<Shards, SysError>::Ok(std::move(shards));
+}
+/**
+ * Creates listening sockets that share the address, all on one IO engine. Accepting still spreads over the engine workers.
+ * @param shards number of sockets
+ * @see netListenSharded
+ */
+template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs, typename Acc> result<ListeningShards<SDomain, SType, SProto, AddressInfo, Errs, Acc>, SysError> netListenSharded(IOYengine* engine, unsigned shards, Errs erracc, Acc acceptor){
+	return netListenSharded<SDomain, SType, SProto, AddressInfo, Errs, Acc>(std::vector<IOYengine*>(std::max(shards, 1u), engine), erracc, acceptor);
+}
 
+/**
+ * Starts listening on all the shards.
+ * The first shard picks the address, the rest bind to exactly the same one (including the port assigned by the system, if any was).
+ * @returns future of each shard, @see AListeningSocket::listen
+ */
+template<int SDomain, int SType, int SProto, typename AddressInfo, typename Errs, typename Acc> result<std::vector<Future<void>>, SysError> listenShards(const ListeningShards<SDomain, SType, SProto, AddressInfo, Errs, Acc>& shards, const NetworkedAddressInfo* addri, const ListenOptions& options = ListenOptions()){
+	using Result = result<std::vector<Future<void>>, SysError>;
+	std::vector<Future<void>> listening;
+	listening.reserve(shards.size());
+	for(size_t i = 0; i < shards.size(); i++){
+		auto lr = i == 0 ? shards[i]->listen(addri, options) : shards[i]->listen(shards[0]->address, options);
+		if(auto err = lr.err()){
+			for(size_t j = 0; j < i; j++) shards[j]->shutdown();
+			return Result::Err(*err);
+		}
+		listening.push_back(*lr.ok());
+	}
+	return Result::Ok(std::move(listening));
+}
+
+using ConnectionResult = result<IOResource, SysError>;
+
+struct ConnectOptions {
+	/// Timer to stagger and bound the attempts with. Without one, candidates are tried one after another, as each fails
+	TickTack* timer = nullptr;
+	/// Head start of an attempt, before the next candidate is raced against it
+	TickTack::Duration stagger = std::chrono::milliseconds(250);
+	/// Limit of each attempt, `0` for none
+	TickTack::Duration attemptTimeout = TickTack::Duration::zero();
+	/// Alternates address families among the candidates (IPv6, IPv4, IPv6...), starting with the first one's
+	bool interleave = true;
+	/// Applied to every attempt
+	SocketOptions socket = SocketOptions();
+};
+
+/**
+ * Connection being established.
+ * Races the candidates (happy eyeballs, epoll): each attempt gets a head start, the first one to connect wins, and the rest are closed.
+ * An attempt failing starts the next one right away.
+ */
 class ConnectingSocket : public IResource {
 	IOYengine::Ticket engine;
 	HandledStrayIOSocket sock;
 	void notify(IOCompletionInfo inf) override;
+	#ifndef _WIN32
+	class Attempt;
+	struct Candidate {
+		::sockaddr_storage address;
+		::socklen_t length;
+		int family, type, protocol;
+	};
+	ConnectOptions options;
+	std::mutex racing;
+	std::vector<Candidate> candidates;
+	std::vector<std::shared_ptr<Attempt>> attempts;
+	/// Attempts in flight
+	size_t pending = 0;
+	bool settled = false;
+	std::optional<SysError> lastError;
+	TickTack::Id staggered = TickTack::UnId;
+	/// Starts attempts until one is in flight, or none is left. Under the lock
+	void launch();
+	void ready(size_t attempt, IOCompletionInfo events);
+	void fail(size_t attempt, SysError err);
+	void timedOut(size_t attempt);
+	void settle(result<void, SysError> && r);
+	#endif
 	public:
 		//exposed exclusively for `netConnectTo`
-		using ConnRedyResult = result<void, std::string>;
+		using ConnRedyResult = result<void, SysError>;
 		std::shared_ptr<OutsideFuture<ConnRedyResult>> redy;
 		std::weak_ptr<ConnectingSocket> slf;
 		ConnectingSocket(IOYengine* e, HandledStrayIOSocket && s) : engine(e->ticket()), sock(std::move(s)), redy(new OutsideFuture<ConnRedyResult>()) {}
+		#ifndef _WIN32
+		ConnectingSocket(IOYengine* e, const ConnectOptions& o);
+		~ConnectingSocket();
+		/**
+		 * Starts racing the candidates
+		 * @returns error if every one of them failed right away
+		 */
+		result<void, SysError> start(const NetworkedAddressInfo* addri);
+		#endif
 		//
 		void cancel() override;
 		/**
 		 * Returns future that completes when connection is established
 		 */
 		Future<ConnectionResult> connest();
+		/**
+		 * Connection, or a timeout error once the deadline passes - the attempts still running are cancelled
+		 */
+		inline Future<ConnectionResult> connest(const Deadline& deadline){ return withDeadline<ConnectionResult>(slf, connest(), deadline); }
 };
 
-template<int SDomain, int SType, int SProto, typename AddressInfo> result<std::shared_ptr<ConnectingSocket>, std::string> netConnectTo(IOYengine* engine, const NetworkedAddressInfo* addri){
-	using Result = result<std::shared_ptr<ConnectingSocket>, std::string>;
-	SocketHandle sock;
+#ifndef _WIN32
+/**
+ * Socket driven by readiness: operations try the call first, and await readiness only if it would block.
+ * Interest is one-shot, rearmed for whatever is awaited.
+ */
+class ReadinessSocket : public IResource {
+	protected:
+		IOYengine::Ticket engine;
+		fd_t sock;
+		std::mutex waiting;
+		std::atomic<bool> closed = false;
+		/// Everything awaiting readiness, per direction
+		std::vector<std::shared_ptr<OutsideFuture<int>>> readable, writable;
+		/**
+		 * @param s @consumes non-blocking socket
+		 */
+		ReadinessSocket(IOYengine* e, fd_t s);
+		/**
+		 * Adds the socket to the poll, with no interest yet
+		 */
+		result<void, SysError> poll();
+		/// Re-registers interest in whatever is awaited, under the lock
+		void rearm();
+		void notify(IOCompletionInfo events) override;
+		/**
+		 * Awaits readiness
+		 * @returns epoll events, `EPOLLHUP` once shut down, `0` if cancelled
+		 */
+		Future<int> ready(bool wr);
+	public:
+		ReadinessSocket(const ReadinessSocket&) = delete;
+		ReadinessSocket& operator=(const ReadinessSocket&) = delete;
+		virtual ~ReadinessSocket();
+		inline fd_t handle() const { return sock; }
+		/**
+		 * Wakes everything waiting, and makes further waits fail
+		 */
+		void shutdown();
+		void cancel() override;
+};
+#endif
+
+/**
+ * Connects to the first candidate that answers
+ * @param options racing of the candidates (ignored on Windows, where the first one is tried)
+ */
+template<int SDomain, int SType, int SProto, typename AddressInfo> result<std::shared_ptr<ConnectingSocket>, SysError> netConnectTo(IOYengine* engine, const NetworkedAddressInfo* addri, const ConnectOptions& options = ConnectOptions()){
+	using Result = result<std::shared_ptr<ConnectingSocket>, SysError>;
 	#ifdef _WIN32
+	SocketHandle sock;
 	sock = ::WSASocket(SDomain, SType, SProto, NULL, 0, WSA_FLAG_OVERLAPPED);
 	if(sock == INVALID_SOCKET) return retSysError<Result>("WSA socket construction failed");
+	if(auto err = applySocketOptions(sock, options.socket, SocketRole::Connecting).err()){
+		::closesocket(sock);
+		return Result::Err(*err);
+	}
 	AddressInfo winIniBindTo = {};
 	auto bind0 = reinterpret_cast<::sockaddr*>(&winIniBindTo);
 	bind0->sa_family = SDomain;
 	if(::bind(sock, bind0, sizeof(AddressInfo)) < 0) return retSysError<Result>("WSA bind failed");
-	#else
-	sock = ::socket(SDomain, SType, SProto);
-	if(sock < 0) return retSysError<Result>("socket construction failed");
-	#endif
 	auto csock = std::make_shared<ConnectingSocket>(engine, std::make_unique<AHandledStrayIOSocket>(sock, true));
 	csock->slf = csock;
-	#ifdef _WIN32
 	if(!::CreateIoCompletionPort(reinterpret_cast<HANDLE>(sock), engine->ioPo->rh, COMPLETION_KEY_IO, 0)) return retSysError<Result>("ioCP add failed");
 	if(!::SetFileCompletionNotificationModes(reinterpret_cast<HANDLE>(sock), FILE_SKIP_COMPLETION_PORT_ON_SUCCESS)) return retSysError<Result>("ioCP set notification mode failed");
-	#else
-	int fsf = ::fcntl(sock, F_GETFL, 0);
-	if(fsf < 0) return retSysError<Result>("socket get flags failed");
-	if(::fcntl(sock, F_SETFL, fsf|O_NONBLOCK) < 0) return retSysError<Result>("socket set non-blocking failed");
-	{
-		::epoll_event epm;
-		epm.events = EPOLLOUT|EPOLLONESHOT;
-		epm.data.ptr = csock.get();
-		if(::epoll_ctl(engine->ioPo->rh, EPOLL_CTL_ADD, sock, &epm) < 0) return retSysError<Result>("epoll add failed");
-	}
-	#endif
 	auto candidate = addri->addresses;
 	for(; candidate; candidate = candidate->ai_next){
-		#ifdef _WIN32
-		if(SystemNetworkingStateControl::MSWSA.ConnectEx(sock, candidate->ai_addr, candidate->ai_addrlen, NULL, 0, NULL, csock->overlapped()))
-		#else
-		if(::connect(sock, candidate->ai_addr, candidate->ai_addrlen) == 0)
-		#endif
-		{
+		if(SystemNetworkingStateControl::MSWSA.ConnectEx(sock, candidate->ai_addr, candidate->ai_addrlen, NULL, 0, NULL, csock->overlapped())){
 			csock->redy->completed(ConnectingSocket::ConnRedyResult::Ok());
 			break;
 		}
-		#ifdef _WIN32
-		if(WSAGetLastError() == ERROR_IO_PENDING)
-		#else
-		if(errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS)
-		#endif
-			break; //async connect, cross your fingers it succeeds. otherwise, and if there're remaining candidates, we're in deep quack
+		if(WSAGetLastError() == ERROR_IO_PENDING) break; //async connect, cross your fingers it succeeds. otherwise, and if there're remaining candidates, we're in deep quack
 	}
 	if(!candidate) return Result::Err("Exhausted address space");
 	return csock;
+	#else
+	auto csock = std::make_shared<ConnectingSocket>(engine, options);
+	csock->slf = csock;
+	if(auto err = csock->start(addri).err()) return Result::Err(*err);
+	return csock;
+	#endif
 }
 
 }
@@ -0,0 +1,229 @@
+#include "iounix.hpp"
+
+#ifndef _WIN32
+
+#include <cstring>
+
+namespace yasync::io {
+
+UnixPairResult unixPair(int type){
+	std::array<fd_t, 2> ends;
+	if(::socketpair(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, ends.data()) < 0) return retSysError<UnixPairResult>("socketpair failed");
+	return UnixPairResult::Ok(ends);
+}
+
+UnixSocket::UnixSocket(IOYengine* e, fd_t s, const UnixSocketOptions& o) : ReadinessSocket(e, s), options(o) {}
+
+UnixSocket::OpenResult UnixSocket::open(IOYengine* engine, fd_t sock, const UnixSocketOptions& opts){
+	auto options = opts;
+	options.maxSize = std::max<size_t>(options.maxSize, 1);
+	int fsf = ::fcntl(sock, F_GETFL, 0);
+	if(fsf < 0 || ::fcntl(sock, F_SETFL, fsf|O_NONBLOCK) < 0){
+		auto err = SysError::last("socket set non-blocking failed");
+		::close(sock);
+		return OpenResult::Err(err);
+	}
+	auto us = std::shared_ptr<UnixSocket>(new UnixSocket(engine, sock, options));
+	us->slf = us;
+	if(auto err = us->poll().err()) return OpenResult::Err(*err);
+	return OpenResult::Ok(us);
+}
+UnixSocket::PairResult UnixSocket::pair(IOYengine* engine, int type, const UnixSocketOptions& options){
+	auto ends = unixPair(type);
+	if(auto err = ends.err()) return PairResult::Err(*err);
+	auto fds = *ends.ok();
+	auto a = open(engine, fds[0], options);
+	if(auto err = a.err()){
+		::close(fds[1]);
+		return PairResult::Err(*err);
+	}
+	auto b = open(engine, fds[1], options);
+	if(auto err = b.err()) return PairResult::Err(*err);
+	return PairResult::Ok(std::array<std::shared_ptr<UnixSocket>, 2>{*a.ok(), *b.ok()});
+}
+
+/**
+ * Socket → UnixMessage?..
+ */
+class UnixReceiver : public IGeneratorT<Maybe<UnixMessageResult>> {
+	std::shared_ptr<UnixSocket> socket;
+	std::vector<char> buff;
+	std::vector<char> control;
+	std::optional<Future<int>> wait = std::nullopt;
+	bool d = false;
+	inline Maybe<UnixMessageResult> finish(std::optional<SysError> err){
+		d = true;
+		if(err) return Maybe<UnixMessageResult>(UnixMessageResult::Err(*err));
+		return Maybe<UnixMessageResult>();
+	}
+	public:
+		UnixReceiver(std::shared_ptr<UnixSocket> s) : socket(s), buff(s->options.maxSize), control(CMSG_SPACE(sizeof(fd_t) * std::max(s->options.maxFds, 1u))) {}
+		bool done() const override { return d; }
+		Generesume<Maybe<UnixMessageResult>> resume(const Yengine*) override {
+			if(wait){
+				int events = wait->result();
+				wait = std::nullopt;
+				if(socket->closed) return finish(std::nullopt);
+				if(events == 0) return finish(SysError("Operation cancelled"));
+			}
+			while(true){
+				::iovec iov = {buff.data(), buff.size()};
+				::msghdr m = {};
+				m.msg_iov = &iov;
+				m.msg_iovlen = 1;
+				m.msg_control = control.data();
+				m.msg_controllen = control.size();
+				auto n = ::recvmsg(socket->sock, &m, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+				if(n > 0){
+					UnixMessage msg;
+					msg.data.assign(buff.data(), buff.data() + n);
+					for(auto c = CMSG_FIRSTHDR(&m); c; c = CMSG_NXTHDR(&m, c)) if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS){
+						auto count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(fd_t);
+						auto at = msg.fds.size();
+						msg.fds.resize(at + count);
+						std::memcpy(msg.fds.data() + at, CMSG_DATA(c), count * sizeof(fd_t));
+					}
+					msg.truncated = m.msg_flags & MSG_TRUNC;
+					msg.fdsTruncated = m.msg_flags & MSG_CTRUNC;
+					return Maybe<UnixMessageResult>(UnixMessageResult::Ok(std::move(msg)));
+				}
+				if(n == 0) return finish(std::nullopt); //peer is gone
+				if(errno == EINTR) continue;
+				if(errno == EWOULDBLOCK || errno == EAGAIN) break;
+				return finish(SysError::last("Receive failed"));
+			}
+			if(socket->closed) return finish(std::nullopt);
+			return *(wait = socket->ready(false));
+		}
+};
+
+Future<Maybe<UnixMessageResult>> UnixSocket::receive(){
+	return defer(Generator<Maybe<UnixMessageResult>>(new UnixReceiver(slf.lock())));
+}
+
+/**
+ * Sends the data, descriptors go with the first (partial) send
+ */
+class UnixSender : public IGeneratorT<UnixSocket::SendResult> {
+	std::shared_ptr<UnixSocket> socket;
+	UnixMessage message;
+	size_t sent = 0;
+	std::vector<char> control;
+	std::optional<Future<bool>> queued = std::nullopt;
+	/// This send is the one in flight
+	bool turn = false;
+	std::optional<Future<int>> wait = std::nullopt;
+	bool d = false;
+	inline void leave(){
+		if(turn) socket->sendDone();
+		turn = false;
+	}
+	inline UnixSocket::SendResult finish(UnixSocket::SendResult && r){
+		d = true;
+		leave();
+		return std::move(r);
+	}
+	public:
+		UnixSender(std::shared_ptr<UnixSocket> s, UnixMessage&& msg) : socket(s), message(std::move(msg)) {
+			if(message.fds.empty()) return;
+			control.assign(CMSG_SPACE(sizeof(fd_t) * message.fds.size()), 0);
+		}
+		~UnixSender(){
+			leave();
+		}
+		bool done() const override { return d; }
+		Generesume<UnixSocket::SendResult> resume(const Yengine*) override {
+			if(!turn){
+				if(!queued && (queued = socket->sendTurn())) return *queued;
+				turn = true;
+			}
+			if(wait){
+				int events = wait->result();
+				wait = std::nullopt;
+				if(socket->closed) return finish(UnixSocket::SendResult::Err("Socket is shut down"));
+				if(events == 0) return finish(UnixSocket::SendResult::Err("Operation cancelled"));
+			}
+			//ancillary data needs a byte to ride along
+			if(message.data.empty() && !message.fds.empty()) return finish(UnixSocket::SendResult::Err("Descriptors can't be sent without data"));
+			while(sent < message.data.size()){
+				::iovec iov = {message.data.data() + sent, message.data.size() - sent};
+				::msghdr m = {};
+				m.msg_iov = &iov;
+				m.msg_iovlen = 1;
+				if(sent == 0 && !control.empty()){
+					m.msg_control = control.data();
+					m.msg_controllen = control.size();
+					auto c = CMSG_FIRSTHDR(&m);
+					c->cmsg_level = SOL_SOCKET;
+					c->cmsg_type = SCM_RIGHTS;
+					c->cmsg_len = CMSG_LEN(sizeof(fd_t) * message.fds.size());
+					std::memcpy(CMSG_DATA(c), message.fds.data(), sizeof(fd_t) * message.fds.size());
+				}
+				auto n = ::sendmsg(socket->sock, &m, MSG_DONTWAIT | MSG_NOSIGNAL);
+				if(n > 0){
+					sent += n;
+					continue;
+				}
+				if(n < 0 && errno == EINTR) continue;
+				if(n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) return *(wait = socket->ready(true));
+				return finish(retSysError<UnixSocket::SendResult>("Send failed"));
+			}
+			return finish(UnixSocket::SendResult::Ok());
+		}
+};
+
+std::optional<Future<bool>> UnixSocket::sendTurn(){
+	std::unique_lock lk(sendLock);
+	if(!sending){
+		sending = true;
+		return std::nullopt;
+	}
+	auto n = std::make_shared<OutsideFuture<bool>>();
+	sendTurns.push_back(n);
+	return n;
+}
+void UnixSocket::sendDone(){
+	std::shared_ptr<OutsideFuture<bool>> next;
+	{
+		std::unique_lock lk(sendLock);
+		if(sendTurns.empty()){
+			sending = false;
+			return;
+		}
+		next = std::move(sendTurns.front());
+		sendTurns.pop_front();
+	}
+	next->completed(true);
+	engine->engine->notify(next);
+}
+
+Future<UnixSocket::SendResult> UnixSocket::send(UnixMessage&& message){
+	return defer(Generator<SendResult>(new UnixSender(slf.lock(), std::move(message))));
+}
+
+Future<UnixSocket::SendResult> UnixSocket::handOver(std::vector<IOResource>&& conns, std::vector<char>&& data){
+	UnixMessage msg{std::move(data), {}};
+	for(auto& conn : conns){
+		if(auto h = conn->detach()) msg.fds.push_back(*h);
+		else {
+			for(auto fd : msg.fds) ::close(fd);
+			return completed(SendResult::Err("Resource can't be detached"));
+		}
+	}
+	conns.clear();
+	auto fds = msg.fds;
+	return send(std::move(msg)) >> [fds](SendResult r){
+		for(auto fd : fds) ::close(fd);
+		return r;
+	};
+}
+
+IOResource adoptSocket(IOYengine* engine, fd_t sock){
+	int fsf = ::fcntl(sock, F_GETFL, 0);
+	if(fsf >= 0 && !(fsf & O_NONBLOCK)) ::fcntl(sock, F_SETFL, fsf|O_NONBLOCK);
+	return engine->taek(HandledResource(new AHandledStrayIOSocket(sock)));
+}
+
+}
+
+#endif
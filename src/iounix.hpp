@@ -0,0 +1,103 @@
+#pragma once
+
+#include "iosock.hpp"
+
+#ifndef _WIN32
+
+#include <deque>
+
+namespace yasync::io {
+
+/**
+ * Data, and descriptors riding along with it
+ */
+struct UnixMessage {
+	std::vector<char> data;
+	/// Received ones are owned by the receiver (close-on-exec), sent ones stay owned by the sender
+	std::vector<fd_t> fds;
+	/// Received message (seqpacket) longer than `maxSize`, the rest of it is lost
+	bool truncated = false;
+	/// Received with more than `maxFds` descriptors, the system closed the rest
+	bool fdsTruncated = false;
+};
+using UnixMessageResult = result<UnixMessage, SysError>;
+
+struct UnixSocketOptions {
+	/// Largest chunk (stream) or message (seqpacket) received at once, longer messages are truncated (and marked so)
+	size_t maxSize = 1 << 16;
+	/// Most descriptors received with one message, the system closes any beyond (and the message is marked so)
+	unsigned maxFds = 16;
+};
+
+using UnixPairResult = result<std::array<fd_t, 2>, SysError>;
+/**
+ * Connected pair of unix sockets, close-on-exec, non-blocking.
+ * One end can be handed over to a child (clear close-on-exec), which opens it with @ref UnixSocket::open.
+ * @param type `SOCK_STREAM` or `SOCK_SEQPACKET` (message boundaries kept)
+ */
+UnixPairResult unixPair(int type = SOCK_STREAM);
+
+/**
+ * Connected unix socket, able to pass descriptors (SCM_RIGHTS).
+ * A front process can accept connections and hand them (@ref IAIOResource::handle) over to workers, each adopting them into its own engine.
+ * One receiving stream at a time. Any number of sends, queued to go out one at a time, so that a stream never interleaves them.
+ */
+class UnixSocket : public ReadinessSocket {
+	UnixSocketOptions options;
+	std::weak_ptr<UnixSocket> slf;
+	std::mutex sendLock;
+	/// A send is in flight
+	bool sending = false;
+	/// Sends waiting for their turn, in order
+	std::deque<std::shared_ptr<OutsideFuture<bool>>> sendTurns;
+	UnixSocket(IOYengine* e, fd_t s, const UnixSocketOptions& o);
+	/**
+	 * @returns turn to await, nothing if it's taken right away
+	 */
+	std::optional<Future<bool>> sendTurn();
+	/// Passes the turn on to the next send waiting
+	void sendDone();
+	friend class UnixReceiver;
+	friend class UnixSender;
+	public:
+		using OpenResult = result<std::shared_ptr<UnixSocket>, SysError>;
+		/**
+		 * Takes on a connected socket (an end of @ref unixPair, an inherited one, an accepted one...)
+		 * @param sock @consumes
+		 */
+		static OpenResult open(IOYengine* engine, fd_t sock, const UnixSocketOptions& options = UnixSocketOptions());
+		using PairResult = result<std::array<std::shared_ptr<UnixSocket>, 2>, SysError>;
+		/**
+		 * Both ends of a fresh @ref unixPair
+		 */
+		static PairResult pair(IOYengine* engine, int type = SOCK_STREAM, const UnixSocketOptions& options = UnixSocketOptions());
+		/**
+		 * Stream of received messages.
+		 * Errors are yielded once and end the stream, the peer closing or shutdown ends it.
+		 */
+		Future<Maybe<UnixMessageResult>> receive();
+		using SendResult = result<void, SysError>;
+		/**
+		 * Sends the data, with the descriptors attached to its first byte.
+		 * The descriptors are duplicated into the peer once sent, keep them open until then.
+		 */
+		Future<SendResult> send(UnixMessage&& message);
+		inline Future<SendResult> send(std::vector<char>&& data, std::vector<fd_t>&& fds){ return send(UnixMessage{std::move(data), std::move(fds)}); }
+		/**
+		 * Hands connections over to the peer: detaches them, sends them along with the data, and closes them here once sent.
+		 * Unlike closing, detaching does not shut the connections down, so they live on with the peer.
+		 * @param conns @consumes resources that can be detached (sockets)
+		 */
+		Future<SendResult> handOver(std::vector<IOResource>&& conns, std::vector<char>&& data);
+};
+using UnixSocketResult = UnixSocket::OpenResult;
+
+/**
+ * Opens asynchronous IO on a (received) socket
+ * @param sock @consumes
+ */
+IOResource adoptSocket(IOYengine* engine, fd_t sock);
+
+}
+
+#endif
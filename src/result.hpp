@@ -9,7 +9,7 @@ template<typename S, typename E> class result {
 	std::variant<S, E> res;
 	protected:
 		result(const std::variant<S, E>& r) : res(r) {}
-		result(std::variant<S, E> && r) : res(r) {}
+		result(std::variant<S, E> && r) : res(std::move(r)) {}
 	public:
 		using OK = S;
 		using ERR = E;
@@ -24,23 +24,38 @@ template<typename S, typename E> class result {
 		const E* err() const { return std::get_if<E>(&res); }
 		S* ok(){ return std::get_if<S>(&res); }
 		E* err(){ return std::get_if<E>(&res); }
-		std::optional<S> okOpt() const { if(auto r = std::get_if<S>(&res)) return *r; else return std::nullopt; }
-		std::optional<E> errOpt() const { if(auto r = std::get_if<E>(&res)) return *r; else return std::nullopt; }
-		S unwrapOk() const { if(auto r = std::get_if<S>(&res)) return *r; else throw std::logic_error("Expected result to be Ok, was Err"); }
-		E unwrapErr() const { if(auto r = std::get_if<E>(&res)) return *r; else throw std::logic_error("Expected result to be Err, was Ok"); }
+		std::optional<S> okOpt() const& { if(auto r = std::get_if<S>(&res)) return *r; else return std::nullopt; }
+		std::optional<E> errOpt() const& { if(auto r = std::get_if<E>(&res)) return *r; else return std::nullopt; }
+		std::optional<S> okOpt() && { if(auto r = std::get_if<S>(&res)) return std::move(*r); else return std::nullopt; }
+		std::optional<E> errOpt() && { if(auto r = std::get_if<E>(&res)) return std::move(*r); else return std::nullopt; }
+		S unwrapOk() const& { if(auto r = std::get_if<S>(&res)) return *r; else throw std::logic_error("Expected result to be Ok, was Err"); }
+		E unwrapErr() const& { if(auto r = std::get_if<E>(&res)) return *r; else throw std::logic_error("Expected result to be Err, was Ok"); }
+		S unwrapOk() && { if(auto r = std::get_if<S>(&res)) return std::move(*r); else throw std::logic_error("Expected result to be Ok, was Err"); }
+		E unwrapErr() && { if(auto r = std::get_if<E>(&res)) return std::move(*r); else throw std::logic_error("Expected result to be Err, was Ok"); }
 		operator bool() const { return isOk(); }
-		template<typename U, typename F> result<U, E> mapOk_(F && f) const { if(auto r = std::get_if<S>(&res)) return result<U, E>::Ok(f(*r)); else return result<U, E>::Err(*err()); }
-		template<typename V, typename F> result<S, V> mapError_(F && f) const { if(auto r = std::get_if<E>(&res)) return result<S, V>::Err(f(*r)); else return result<S, V>::Ok(*ok()); }
-		template<typename F> decltype(auto) mapOk(F && f) const {
+		template<typename U, typename F> result<U, E> mapOk_(F && f) const& { if(auto r = std::get_if<S>(&res)) return result<U, E>::Ok(f(*r)); else return result<U, E>::Err(*err()); }
+		template<typename V, typename F> result<S, V> mapError_(F && f) const& { if(auto r = std::get_if<E>(&res)) return result<S, V>::Err(f(*r)); else return result<S, V>::Ok(*ok()); }
+		template<typename U, typename F> result<U, E> mapOk_(F && f) && { if(auto r = std::get_if<S>(&res)) return result<U, E>::Ok(f(std::move(*r))); else return result<U, E>::Err(std::move(*err())); }
+		template<typename V, typename F> result<S, V> mapError_(F && f) && { if(auto r = std::get_if<E>(&res)) return result<S, V>::Err(f(std::move(*r))); else return result<S, V>::Ok(std::move(*ok())); }
+		template<typename F> decltype(auto) mapOk(F && f) const& {
 			using U = std::decay_t<decltype(f(*std::get_if<S>(&res)))>;
 			return mapOk_<U, F>(std::move(f));
 		}
-		template<typename F> decltype(auto) mapError(F && f) const {
+		template<typename F> decltype(auto) mapError(F && f) const& {
 			using V = std::decay_t<decltype(f(*std::get_if<E>(&res)))>;
 			return mapError_<V, F>(std::move(f));
 		}
-		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) const { return isOk() ? fs(*ok()) : fe(*err()); }
-		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe){ return isOk() ? fs(std::move(*ok())) : fe(std::move(*err())); }
+		template<typename F> decltype(auto) mapOk(F && f) && {
+			using U = std::decay_t<decltype(f(std::move(*std::get_if<S>(&res))))>;
+			return std::move(*this).template mapOk_<U, F>(std::move(f));
+		}
+		template<typename F> decltype(auto) mapError(F && f) && {
+			using V = std::decay_t<decltype(f(std::move(*std::get_if<E>(&res))))>;
+			return std::move(*this).template mapError_<V, F>(std::move(f));
+		}
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) const& { return isOk() ? fs(*ok()) : fe(*err()); }
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) & { return isOk() ? fs(std::move(*ok())) : fe(std::move(*err())); }
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) && { return isOk() ? fs(std::move(*ok())) : fe(std::move(*err())); }
 		template<typename F> decltype(auto) operator>>(F && f) const { return f(*this); }
 		template<typename F> decltype(auto) operator>>(F && f){ return f(std::move(*this)); }
 	public:
@@ -65,23 +80,38 @@ template<typename T> class result<T, T> {
 		const T* err() const { return isErr() ? &thing : nullptr; }
 		T* ok(){ return isOk() ? &thing : nullptr; }
 		T* err(){ return isErr() ? &thing : nullptr; }
-		std::optional<T> okOpt() const { if(isOk()) return thing; else return std::nullopt; }
-		std::optional<T> errOpt() const { if(isErr()) return thing; else return std::nullopt; }
-		T unwrapOk() const { if(isOk()) return thing; else throw std::logic_error("Expected result to be Ok, was Err"); }
-		T unwrapErr() const { if(isErr()) return thing; else throw std::logic_error("Expected result to be Err, was Ok"); }
+		std::optional<T> okOpt() const& { if(isOk()) return thing; else return std::nullopt; }
+		std::optional<T> errOpt() const& { if(isErr()) return thing; else return std::nullopt; }
+		std::optional<T> okOpt() && { if(isOk()) return std::move(thing); else return std::nullopt; }
+		std::optional<T> errOpt() && { if(isErr()) return std::move(thing); else return std::nullopt; }
+		T unwrapOk() const& { if(isOk()) return thing; else throw std::logic_error("Expected result to be Ok, was Err"); }
+		T unwrapErr() const& { if(isErr()) return thing; else throw std::logic_error("Expected result to be Err, was Ok"); }
+		T unwrapOk() && { if(isOk()) return std::move(thing); else throw std::logic_error("Expected result to be Ok, was Err"); }
+		T unwrapErr() && { if(isErr()) return std::move(thing); else throw std::logic_error("Expected result to be Err, was Ok"); }
 		operator bool() const { return isOk(); }
-		template<typename U, typename F> result<U, T> mapOk_(F && f) const { if(isOk()) return result<U, T>::Ok(f(thing)); else return result<U, T>::Err(*err()); }
-		template<typename V, typename F> result<T, V> mapError_(F && f) const { if(isErr()) return result<T, V>::Err(f(thing)); else return result<T, V>::Ok(*ok()); }
-		template<typename F> decltype(auto) mapOk(F && f) const {
+		template<typename U, typename F> result<U, T> mapOk_(F && f) const& { if(isOk()) return result<U, T>::Ok(f(thing)); else return result<U, T>::Err(*err()); }
+		template<typename V, typename F> result<T, V> mapError_(F && f) const& { if(isErr()) return result<T, V>::Err(f(thing)); else return result<T, V>::Ok(*ok()); }
+		template<typename U, typename F> result<U, T> mapOk_(F && f) && { if(isOk()) return result<U, T>::Ok(f(std::move(thing))); else return result<U, T>::Err(std::move(thing)); }
+		template<typename V, typename F> result<T, V> mapError_(F && f) && { if(isErr()) return result<T, V>::Err(f(std::move(thing))); else return result<T, V>::Ok(std::move(thing)); }
+		template<typename F> decltype(auto) mapOk(F && f) const& {
 			using U = std::decay_t<decltype(f(thing))>;
 			return mapOk_<U, F>(std::move(f));
 		}
-		template<typename F> decltype(auto) mapError(F && f) const {
+		template<typename F> decltype(auto) mapError(F && f) const& {
 			using V = std::decay_t<decltype(f(thing))>;
 			return mapError_<V, F>(std::move(f));
 		}
-		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) const { return isOk() ? fs(thing) : fe(thing); }
-		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe){ return isOk() ? fs(std::move(thing)) : fe(std::move(thing)); }
+		template<typename F> decltype(auto) mapOk(F && f) && {
+			using U = std::decay_t<decltype(f(std::move(thing)))>;
+			return std::move(*this).template mapOk_<U, F>(std::move(f));
+		}
+		template<typename F> decltype(auto) mapError(F && f) && {
+			using V = std::decay_t<decltype(f(std::move(thing)))>;
+			return std::move(*this).template mapError_<V, F>(std::move(f));
+		}
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) const& { return isOk() ? fs(thing) : fe(thing); }
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) & { return isOk() ? fs(std::move(thing)) : fe(std::move(thing)); }
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) && { return isOk() ? fs(std::move(thing)) : fe(std::move(thing)); }
 		template<typename F> decltype(auto) operator>>(F && f) const { return f(*this); }
 		template<typename F> decltype(auto) operator>>(F && f){ return f(std::move(*this)); }
 	public:
@@ -102,20 +132,33 @@ template<typename S> class result<S, void> {
 		bool isErr() const { return !okay.has_value(); }
 		const S* ok() const { return okay.has_value() ? okay.operator->() : nullptr; }
 		S* ok(){ return okay.has_value() ? okay.operator->() : nullptr; }
-		S unwrapOk() const { if(isOk()) return *okay; else throw std::logic_error("Expected result to be Ok, was Err"); }
-		std::optional<S> okOpt() const { return okay; }
-		template<typename U, typename F> result<U, void> mapOk_(F && f) const { if(auto r = ok()) return result<U, void>::Ok(f(*r)); else return result<U, void>::Err(); }
-		template<typename V, typename F> result<S, V> mapError_(F && f) const { if(isErr()) return result<S, V>::Err(f()); else return result<S, V>::Ok(*ok()); }
-		template<typename F> decltype(auto) mapOk(F && f) const {
+		S unwrapOk() const& { if(isOk()) return *okay; else throw std::logic_error("Expected result to be Ok, was Err"); }
+		S unwrapOk() && { if(isOk()) return std::move(*okay); else throw std::logic_error("Expected result to be Ok, was Err"); }
+		std::optional<S> okOpt() const& { return okay; }
+		std::optional<S> okOpt() && { return std::move(okay); }
+		template<typename U, typename F> result<U, void> mapOk_(F && f) const& { if(auto r = ok()) return result<U, void>::Ok(f(*r)); else return result<U, void>::Err(); }
+		template<typename V, typename F> result<S, V> mapError_(F && f) const& { if(isErr()) return result<S, V>::Err(f()); else return result<S, V>::Ok(*ok()); }
+		template<typename U, typename F> result<U, void> mapOk_(F && f) && { if(auto r = ok()) return result<U, void>::Ok(f(std::move(*r))); else return result<U, void>::Err(); }
+		template<typename V, typename F> result<S, V> mapError_(F && f) && { if(isErr()) return result<S, V>::Err(f()); else return result<S, V>::Ok(std::move(*ok())); }
+		template<typename F> decltype(auto) mapOk(F && f) const& {
 			using U = std::decay_t<decltype(f(*okay))>;
 			return mapOk_<U, F>(std::move(f));
 		}
-		template<typename F> decltype(auto) mapError(F && f) const {
+		template<typename F> decltype(auto) mapError(F && f) const& {
 			using V = std::decay_t<decltype(f())>;
 			return mapError_<V, F>(std::move(f));
 		}
-		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) const { return isOk() ? fs(*ok()) : fe(); }
-		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe){ return isOk() ? fs(std::move(*ok())) : fe(); }
+		template<typename F> decltype(auto) mapOk(F && f) && {
+			using U = std::decay_t<decltype(f(std::move(*okay)))>;
+			return std::move(*this).template mapOk_<U, F>(std::move(f));
+		}
+		template<typename F> decltype(auto) mapError(F && f) && {
+			using V = std::decay_t<decltype(f())>;
+			return std::move(*this).template mapError_<V, F>(std::move(f));
+		}
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) const& { return isOk() ? fs(*ok()) : fe(); }
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) & { return isOk() ? fs(std::move(*ok())) : fe(); }
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) && { return isOk() ? fs(std::move(*ok())) : fe(); }
 		template<typename F> decltype(auto) operator>>(F && f) const { return f(*this); }
 		template<typename F> decltype(auto) operator>>(F && f){ return f(std::move(*this)); }
 	public:
@@ -135,20 +178,33 @@ template<typename E> class result<void, E> {
 		bool isErr() const { return error.has_value(); }
 		const E* err() const { return error.has_value() ? error.operator->() : nullptr; }
 		E* err(){ return error.has_value() ? error.operator->() : nullptr; }
-		E unwrapErr() const { if(isErr()) return *error; else throw std::logic_error("Expected result to be Err, was Ok"); }
-		std::optional<E> errOpt() const { return error; }
-		template<typename U, typename F> result<U, E> mapOk_(F && f) const { if(isOk()) return result<U, E>::Ok(f()); else return result<U, E>::Err(*err()); }
-		template<typename V, typename F> result<void, V> mapError_(F && f) const { if(auto r = err()) return result<void, V>::Err(f(*r)); else return result<void, V>::Ok(); }
-		template<typename F> decltype(auto) mapOk(F && f) const {
+		E unwrapErr() const& { if(isErr()) return *error; else throw std::logic_error("Expected result to be Err, was Ok"); }
+		E unwrapErr() && { if(isErr()) return std::move(*error); else throw std::logic_error("Expected result to be Err, was Ok"); }
+		std::optional<E> errOpt() const& { return error; }
+		std::optional<E> errOpt() && { return std::move(error); }
+		template<typename U, typename F> result<U, E> mapOk_(F && f) const& { if(isOk()) return result<U, E>::Ok(f()); else return result<U, E>::Err(*err()); }
+		template<typename V, typename F> result<void, V> mapError_(F && f) const& { if(auto r = err()) return result<void, V>::Err(f(*r)); else return result<void, V>::Ok(); }
+		template<typename U, typename F> result<U, E> mapOk_(F && f) && { if(isOk()) return result<U, E>::Ok(f()); else return result<U, E>::Err(std::move(*err())); }
+		template<typename V, typename F> result<void, V> mapError_(F && f) && { if(auto r = err()) return result<void, V>::Err(f(std::move(*r))); else return result<void, V>::Ok(); }
+		template<typename F> decltype(auto) mapOk(F && f) const& {
 			using U = std::decay_t<decltype(f())>;
 			return mapOk_<U, F>(std::move(f));
 		}
-		template<typename F> decltype(auto) mapError(F && f) const {
-			using V = std::decay_t<decltype(f(*err))>;
+		template<typename F> decltype(auto) mapError(F && f) const& {
+			using V = std::decay_t<decltype(f(*error))>;
 			return mapError_<V, F>(std::move(f));
 		}
-		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) const { return isOk() ? fs() : fe(*err()); }
-		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe){ return isOk() ? fs() : fe(std::move(*err())); }
+		template<typename F> decltype(auto) mapOk(F && f) && {
+			using U = std::decay_t<decltype(f())>;
+			return std::move(*this).template mapOk_<U, F>(std::move(f));
+		}
+		template<typename F> decltype(auto) mapError(F && f) && {
+			using V = std::decay_t<decltype(f(std::move(*error)))>;
+			return std::move(*this).template mapError_<V, F>(std::move(f));
+		}
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) const& { return isOk() ? fs() : fe(*err()); }
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) & { return isOk() ? fs() : fe(std::move(*err())); }
+		template<typename FS, typename FE> decltype(auto) ifElse(FS && fs, FE && fe) && { return isOk() ? fs() : fe(std::move(*err())); }
 		template<typename F> decltype(auto) operator>>(F && f) const { return f(*this); }
 		template<typename F> decltype(auto) operator>>(F && f){ return f(std::move(*this)); }
 	public:
@@ -189,7 +245,7 @@ template<> class result<void, void> {
 namespace magikop {
 
 template<typename FS, typename FE> inline decltype(auto) operator|(FS && fs, FE && fe){
-	return [fs = std::move(fs), fe = std::move(fe)](auto r){ return r.ifElse(std::move(fs), std::move(fe)); };
+	return [fs = std::move(fs), fe = std::move(fe)](auto r){ return std::move(r).ifElse(std::move(fs), std::move(fe)); };
 }
 
 }
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+
+namespace yasync {
+
+constexpr size_t CACHE_LINE = 64;
+
+/**
+ * Indices of a bounded lock-free single producer single consumer byte ring, the data lives elsewhere.
+ * Exactly one thread may push at a time, and exactly one may pop at a time.
+ * Each side keeps its index, and its last look at the other side's index, on its own cache line - the other side's line is only touched when the cached look runs out.
+ * The indices are address free, so they may sit in memory shared among processes.
+ */
+class SpscRingIndices {
+	/// Consumer side
+	alignas(CACHE_LINE) std::atomic<size_t> head = 0;
+	size_t tailSeen = 0;
+	/// Producer side
+	alignas(CACHE_LINE) std::atomic<size_t> tail = 0;
+	size_t headSeen = 0;
+	static_assert(std::atomic<size_t>::is_always_lock_free, "Ring indices must be lock-free");
+	public:
+		/**
+		 * Producer: copies in as much of the data as fits
+		 * @param buff ring data
+		 * @param cap ring capacity, a power of 2
+		 * @returns number of bytes pushed
+		 */
+		size_t push(char* buff, size_t cap, const char* data, size_t size){
+			auto t = tail.load(std::memory_order_relaxed);
+			if(cap - (t - headSeen) < size) headSeen = head.load(std::memory_order_acquire);
+			auto n = std::min(size, cap - (t - headSeen));
+			if(n == 0) return 0;
+			auto at = t & (cap-1);
+			auto first = std::min(n, cap - at);
+			std::memcpy(buff + at, data, first);
+			std::memcpy(buff, data + first, n - first);
+			tail.store(t + n, std::memory_order_release);
+			return n;
+		}
+		/**
+		 * Consumer: appends up to `max` readable bytes to `out`
+		 * @param buff ring data
+		 * @param cap ring capacity, a power of 2
+		 * @returns number of bytes popped
+		 */
+		size_t pop(const char* buff, size_t cap, std::vector<char>& out, size_t max = SIZE_MAX){
+			auto h = head.load(std::memory_order_relaxed);
+			if(tailSeen - h < max) tailSeen = tail.load(std::memory_order_acquire);
+			auto n = std::min(tailSeen - h, max);
+			if(n == 0) return 0;
+			auto at = h & (cap-1);
+			auto first = std::min(n, cap - at);
+			out.insert(out.end(), buff + at, buff + at + first);
+			out.insert(out.end(), buff, buff + (n - first));
+			head.store(h + n, std::memory_order_release);
+			return n;
+		}
+		/// Consumer: whether there is nothing to pop
+		inline bool empty() const { return tail.load(std::memory_order_acquire) == head.load(std::memory_order_relaxed); }
+		/// Producer: whether there is no room to push
+		inline bool full(size_t cap) const { return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == cap; }
+};
+
+/// Rounds up to a power of 2
+inline size_t ringCapacity(size_t n){
+	size_t p = 1;
+	while(p < n) p <<= 1;
+	return p;
+}
+
+/**
+ * Bounded lock-free single producer single consumer byte ring.
+ * @see SpscRingIndices
+ */
+class SpscRing {
+	std::unique_ptr<char[]> buff;
+	size_t cap;
+	SpscRingIndices indices;
+	public:
+		/**
+		 * @param capacity capacity in bytes, rounded up to a power of 2
+		 */
+		explicit SpscRing(size_t capacity) : cap(ringCapacity(capacity)) {
+			buff.reset(new char[cap]);
+		}
+		SpscRing(const SpscRing&) = delete;
+		SpscRing& operator=(const SpscRing&) = delete;
+		inline size_t capacity() const { return cap; }
+		/**
+		 * Producer: copies in as much of the data as fits
+		 * @returns number of bytes pushed
+		 */
+		inline size_t push(const char* data, size_t size){ return indices.push(buff.get(), cap, data, size); }
+		/**
+		 * Consumer: appends up to `max` readable bytes to `out`
+		 * @returns number of bytes popped
+		 */
+		inline size_t pop(std::vector<char>& out, size_t max = SIZE_MAX){ return indices.pop(buff.get(), cap, out, max); }
+		/// Consumer: whether there is nothing to pop
+		inline bool empty() const { return indices.empty(); }
+		/// Producer: whether there is no room to push
+		inline bool full() const { return indices.full(cap); }
+};
+
+}
@@ -19,11 +19,25 @@ std::string printSysError(const std::string& message, syserr_t e){
 	return compose.str();
 }
 std::string printSysError(const std::string& message){
-	return printSysError(message,
+	return printSysError(message, lastSysError());
+}
+syserr_t lastSysError(){
 	#ifdef _WIN32
-	::GetLastError()
+	return ::GetLastError();
 	#else
-	errno
+	return errno;
 	#endif
-	);
+}
+
+std::string SysError::describeSystem(const char* message, syserr_t code){ return printSysError(message, code); }
+std::string SysError::describeDetail(const char* message, syserr_t code){
+	std::ostringstream compose;
+	compose << message << " (" << code << ")";
+	return compose.str();
+}
+std::string SysError::str() const {
+	return describe ? describe(msg, ecode) : std::string(msg);
+}
+std::ostream& operator<<(std::ostream& os, const SysError& e){
+	return os << e.str();
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <ostream>
+#include <type_traits>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -11,5 +13,61 @@ using syserr_t = int;
 
 std::string printSysError(const std::string& message, syserr_t e);
 std::string printSysError(const std::string& message);
+syserr_t lastSysError();
+
+/**
+ * Compact error - a static message, a code and how to describe that code.
+ * Nothing is formatted (nor allocated) until the error is printed.
+ */
+class SysError {
+	public:
+		/**
+		 * Formats the message and the code
+		 */
+		using Describe = std::string(*)(const char* message, syserr_t code);
+		static std::string describeSystem(const char* message, syserr_t code);
+		static std::string describeDetail(const char* message, syserr_t code);
+	private:
+		const char* msg;
+		syserr_t ecode;
+		Describe describe;
+	public:
+		/**
+		 * @param message static message
+		 */
+		SysError(const char* message = "Unknown error") : msg(message), ecode(0), describe(nullptr) {}
+		/**
+		 * @param message static message
+		 * @param code error code
+		 * @param d how to describe the code, system error by default
+		 */
+		SysError(const char* message, syserr_t code, Describe d = describeSystem) : msg(message), ecode(code), describe(d) {}
+		/**
+		 * Captures last system error
+		 */
+		static inline SysError last(const char* message){ return SysError(message, lastSysError()); }
+		/**
+		 * Message with detail code, like an unexpected event
+		 */
+		static inline SysError detail(const char* message, syserr_t code){ return SysError(message, code, describeDetail); }
+		inline const char* message() const { return msg; }
+		inline syserr_t code() const { return ecode; }
+		inline bool hasCode() const { return describe != nullptr; }
+		std::string str() const;
+		inline operator std::string() const { return str(); }
+};
+std::ostream& operator<<(std::ostream& os, const SysError& e);
+
 template<typename R> R retSysError(const std::string& message, syserr_t e){ return R::Err(printSysError(message, e)); }
 template<typename R> R retSysError(const std::string& message){ return R::Err(printSysError(message)); }
+/**
+ * @param message static message
+ */
+template<typename R> R retSysError(const char* message, syserr_t e){
+	if constexpr (std::is_same<typename R::ERR, SysError>::value) return R::Err(SysError(message, e));
+	else return R::Err(printSysError(message, e));
+}
+/**
+ * @param message static message
+ */
+template<typename R> R retSysError(const char* message){ return retSysError<R>(message, lastSysError()); }
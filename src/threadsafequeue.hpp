@@ -52,6 +52,11 @@ public:
 		return popw;
 	}
 
+	size_t size(){
+		std::unique_lock<std::mutex> lock(mutex);
+		return currentSize;
+	}
+
     // Push v to queue.  Blocks if queue is full.
     void push(T const & v)
     {
@@ -15,6 +15,7 @@ void TickTack::shutdown(){
 		stahp = true;
 		cvStahp.notify_one();
 		std::swap(rent, ent);
+		due.clear();
 	}
 	for(auto t = rent.begin(); t != rent.end(); t++) t->f(t->id, true);
 	worker.join();
@@ -24,13 +25,17 @@ TickTack::Id TickTack::start(const TimePoint& t, const Duration& d, Callback &&
 	std::unique_lock lok(lock);
 	auto id = nid++;
 	ent.emplace(TickTack::El{t, d, id, std::move(f)});
+	due.emplace(id, t);
 	return id;
 }
 
 void TickTack::stop(Id id){
 	if(id) if(auto t = ([this, id]() -> std::optional<El> {
 		std::unique_lock lok(lock);
-		auto t = std::find_if(ent.begin(), ent.end(), [id](const El& el){ return el.id == id; });
+		auto d = due.find(id);
+		if(d == due.end()) return std::nullopt;
+		auto t = ent.find(El(d->second, Duration::zero(), id, Callback()));
+		due.erase(d);
 		if(t == ent.end()) return std::nullopt;
 		return std::move(ent.extract(t).value());
 	})()) t->f(t->id, true);
@@ -43,6 +48,7 @@ void TickTack::threadwork(){
 		auto next = ent.begin();
 		if(next == ent.end()) return std::nullopt;
 		if(next->t > Clock::now()) return std::nullopt;
+		due.erase(next->id);
 		return std::move(ent.extract(next).value());
 	};
 	while(!stahp){
@@ -52,6 +58,7 @@ void TickTack::threadwork(){
 			if(tik.d != Duration::zero()){
 				tik.t += tik.d;
 				std::unique_lock lok(lock);
+				due.emplace(tik.id, tik.t);
 				ent.emplace(std::move(tik));
 			}
 		}
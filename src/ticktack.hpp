@@ -4,6 +4,7 @@
 #include <condition_variable>
 #include <functional>
 #include <set>
+#include <unordered_map>
 #include <chrono>
 #include <atomic>
 #include <thread>
@@ -51,6 +52,8 @@ class TickTack {
 		};
 		std::mutex lock;
 		std::set<El> ent;
+		/// When each pending timer is due, to find it without a scan
+		std::unordered_map<Id, TimePoint> due;
 		std::atomic<Id> nid = UnId+1;
 	public:
 		TickTack();